@@ -34,17 +34,63 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #if defined(_WIN32)
 #include <windows.h>
+#include <psapi.h>
 #include <gl/gl.h>
 #include "glext.h"
 #elif defined(__APPLE__)
 #include <AGL/agl.h>
+#include <OpenGL/glext.h>
+#include <dlfcn.h>
+#include <mach/mach.h>
+#include <mach/mach_time.h>
 #else // Linux
 #include <GL/glx.h>
+#include <time.h>
+#include <unistd.h>
 #endif
 
 #include <string>
+#include <vector>
+#include <algorithm>
+
+// Tokens which are newer than the glext.h we ship for Windows.
+#ifndef GL_LOW_FLOAT
+#define GL_LOW_FLOAT                      0x8DF0
+#define GL_MEDIUM_FLOAT                   0x8DF1
+#define GL_HIGH_FLOAT                     0x8DF2
+#define GL_LOW_INT                        0x8DF3
+#define GL_MEDIUM_INT                     0x8DF4
+#define GL_HIGH_INT                       0x8DF5
+#endif
+#ifndef GL_NVX_gpu_memory_info
+#define GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX         0x9047
+#define GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX   0x9048
+#define GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX 0x9049
+#endif
+#ifndef GL_RESET_NOTIFICATION_STRATEGY_ARB
+#define GL_CONTEXT_FLAG_ROBUST_ACCESS_BIT_ARB 0x00000004
+#define GL_LOSE_CONTEXT_ON_RESET_ARB      0x8252
+#define GL_RESET_NOTIFICATION_STRATEGY_ARB 0x8256
+#define GL_NO_RESET_NOTIFICATION_ARB      0x8261
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT               0x8FBB
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2           0x9274
+#define GL_COMPRESSED_RGBA8_ETC2_EAC      0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR   0x93B0
+#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR   0x93B7
+#endif
 
 #ifdef GLEW_MX
 GLEWContext _glewctx;
@@ -72,12 +118,62 @@ typedef struct GLContextStruct
   GLXContext ctx;
   Window wnd;
   Colormap cmap;
+  GLXPbuffer pbuf;
+  bool shared_dpy;
 #endif
 } GLContext;
 
+enum ContextSurface {
+  WINDOW_SURFACE,
+  PBUFFER_SURFACE,
+  NO_SURFACE
+};
+
+// Non-default ways to create a context, for checks which need something other
+// than a plain windowed context.
+typedef struct ContextOptionsStruct
+{
+  // Request robust buffer access and a lose-context-on-reset notification
+  // strategy, as browsers do when they can.
+  bool robust;
+  ContextSurface surface;
+  // If set, reuse this context's window system connection instead of opening
+  // a new one. Only GLX has a connection separate from the context.
+  struct GLContextStruct* connection;
+} ContextOptions;
+
+void InitContextOptions (ContextOptions* options);
+
 void InitContext (GLContext* ctx);
 GLboolean CreateContext (GLContext* ctx);
+// Returns GL_TRUE on error, including when the platform can't provide the
+// requested options.
+GLboolean CreateContextWithOptions (GLContext* ctx, const ContextOptions* options);
+// Returns GL_FALSE if CreateContextWithOptions can't request robust contexts
+// on this platform at all, so failing to get one says nothing about the host.
+GLboolean CanCreateRobustContext (void);
+GLboolean MakeContextCurrent (GLContext* ctx);
 void DestroyContext (GLContext* ctx);
+// Whether the context renders directly rather than through the window system
+// protocol, e.g. GLX forwarded to a remote X server.
+GLboolean IsDirectContext (GLContext* ctx);
+
+// Identity and memory of the device behind a context, as reported by the
+// window system (e.g. GLX_MESA_query_renderer). Values that couldn't be
+// queried are left at zero.
+typedef struct RendererInfoStruct
+{
+  unsigned int vendor_id;
+  unsigned int device_id;
+  unsigned int video_memory_mb;
+  bool accelerated;
+  bool unified_memory;
+  std::string vendor;
+  std::string device;
+} RendererInfo;
+
+// Returns GL_FALSE if the platform has no way to query the renderer.
+GLboolean QueryRendererInfo (GLContext* ctx, RendererInfo* info);
 
 enum ButtonSet {
  NONE_BUTTON = 0,
@@ -89,6 +185,170 @@ enum ButtonSet {
 ButtonSet ReportInfo(const std::string& title, const std::string& msg, ButtonSet buttons = OK_BUTTON);
 void LoadURL(const std::string& url);
 
+// Monotonic wall clock time in seconds, for timing checks.
+double GetTime();
+// Resident set size of this process in bytes, or 0 if it can't be determined.
+size_t GetResidentMemory();
+
+// Summary of a set of timings, all in the same unit as the samples.
+typedef struct TimingStatsStruct
+{
+  double min, median, p95, p99, max;
+} TimingStats;
+
+void ComputeTimingStats(std::vector<double> samples, TimingStats* stats);
+
+// Times benchmark passes on both sides: how long the CPU took to submit the
+// pass, and how long the GPU took to execute it. GPU time comes from timer
+// queries when the driver has them, alternating between two queries so a
+// result is only waited for a pass later. Otherwise we glFinish once when the
+// run is finished and average the CPU clock over its passes, which also
+// includes submission and anything done between passes, but never drains the
+// pipeline mid run. Passes can't be nested.
+typedef struct GPUTimerStruct
+{
+  bool use_queries;
+  bool check_disjoint;
+  GLuint queries[2];
+  bool pending[2];
+  int current;
+  double pass_start;
+  double run_start;
+  int unfinished_passes;
+  std::vector<double> cpu_samples;
+  std::vector<double> gpu_samples;
+} GPUTimer;
+
+bool HasTimerQueries();
+void InitGPUTimer(GPUTimer* timer);
+void BeginGPUTimer(GPUTimer* timer);
+void EndGPUTimer(GPUTimer* timer);
+// Waits for outstanding results, must be called before using the samples.
+void FinishGPUTimer(GPUTimer* timer);
+void DestroyGPUTimer(GPUTimer* timer);
+// Median CPU and GPU time per pass, for reports.
+std::string FormatGPUTimer(GPUTimer* timer);
+
+// Anything past OpenGL 1.1 has to be looked up at runtime since that is all
+// the Windows GL library exports. Each function lists the GL version it became
+// core in, an extension which provides it under the same name, and one which
+// provides it with the extension's suffix (e.g. EXT_framebuffer_object's
+// glGenFramebuffersEXT). Vendor extension functions are listed under their
+// suffixed names with no version. GLX hands back a stub for any name, so the
+// name to load is picked from what the driver advertises rather than by
+// looking for NULL, and checks should still test the GL version or extension
+// string before calling anything.
+#define WIW_GL_FUNCTIONS \
+    WIW_GL_FUNCTION(void, GenFramebuffers, (GLsizei n, GLuint* framebuffers), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, DeleteFramebuffers, (GLsizei n, const GLuint* framebuffers), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, BindFramebuffer, (GLenum target, GLuint framebuffer), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, FramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(GLenum, CheckFramebufferStatus, (GLenum target), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, GenRenderbuffers, (GLsizei n, GLuint* renderbuffers), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, DeleteRenderbuffers, (GLsizei n, const GLuint* renderbuffers), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, BindRenderbuffer, (GLenum target, GLuint renderbuffer), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, RenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, RenderbufferStorageMultisample, (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_multisample") \
+    WIW_GL_FUNCTION(void, GetRenderbufferParameteriv, (GLenum target, GLenum pname, GLint* params), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, BlitFramebuffer, (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_blit") \
+    WIW_GL_FUNCTION(void, CompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void* data), 1, 3, NULL, "GL_ARB_texture_compression") \
+    WIW_GL_FUNCTION(void, GenerateMipmap, (GLenum target), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(void, FramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), 3, 0, "GL_ARB_framebuffer_object", "GL_EXT_framebuffer_object") \
+    WIW_GL_FUNCTION(GLuint, CreateShader, (GLenum type), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar** string, const GLint* length), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, CompileShader, (GLuint shader), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, GetShaderiv, (GLuint shader, GLenum pname, GLint* params), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, DeleteShader, (GLuint shader), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(GLuint, CreateProgram, (void), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, AttachShader, (GLuint program, GLuint shader), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, BindAttribLocation, (GLuint program, GLuint index, const GLchar* name), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, LinkProgram, (GLuint program), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, GetProgramiv, (GLuint program, GLenum pname, GLint* params), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, GetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, UseProgram, (GLuint program), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, DeleteProgram, (GLuint program), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(GLint, GetUniformLocation, (GLuint program, const GLchar* name), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, GetActiveUniform, (GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, Uniform1f, (GLint location, GLfloat v0), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, Uniform1i, (GLint location, GLint v0), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, Uniform2fv, (GLint location, GLsizei count, const GLfloat* value), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, Uniform4fv, (GLint location, GLsizei count, const GLfloat* value), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, UniformMatrix4fv, (GLint location, GLsizei count, GLboolean transpose, const GLfloat* value), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(GLuint, GetUniformBlockIndex, (GLuint program, const GLchar* uniformBlockName), 3, 1, "GL_ARB_uniform_buffer_object", NULL) \
+    WIW_GL_FUNCTION(void, UniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), 3, 1, "GL_ARB_uniform_buffer_object", NULL) \
+    WIW_GL_FUNCTION(void, BlendFuncSeparate, (GLenum sfactorRGB, GLenum dfactorRGB, GLenum sfactorAlpha, GLenum dfactorAlpha), 1, 4, NULL, "GL_EXT_blend_func_separate") \
+    WIW_GL_FUNCTION(void, GetShaderPrecisionFormat, (GLenum shadertype, GLenum precisiontype, GLint* range, GLint* precision), 4, 1, "GL_ARB_ES2_compatibility", NULL) \
+    WIW_GL_FUNCTION(GLenum, GetGraphicsResetStatus, (void), 4, 5, NULL, "GL_ARB_robustness") \
+    WIW_GL_FUNCTION(void, GenBuffers, (GLsizei n, GLuint* buffers), 1, 5, NULL, "GL_ARB_vertex_buffer_object") \
+    WIW_GL_FUNCTION(void, DeleteBuffers, (GLsizei n, const GLuint* buffers), 1, 5, NULL, "GL_ARB_vertex_buffer_object") \
+    WIW_GL_FUNCTION(void, BindBuffer, (GLenum target, GLuint buffer), 1, 5, NULL, "GL_ARB_vertex_buffer_object") \
+    WIW_GL_FUNCTION(void, BufferData, (GLenum target, GLsizeiptr size, const void* data, GLenum usage), 1, 5, NULL, "GL_ARB_vertex_buffer_object") \
+    WIW_GL_FUNCTION(void, BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void* data), 1, 5, NULL, "GL_ARB_vertex_buffer_object") \
+    WIW_GL_FUNCTION(void, BindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), 3, 0, "GL_ARB_uniform_buffer_object", NULL) \
+    WIW_GL_FUNCTION(void, VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, EnableVertexAttribArray, (GLuint index), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, DisableVertexAttribArray, (GLuint index), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(GLint, GetAttribLocation, (GLuint program, const GLchar* name), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, VertexAttrib2fv, (GLuint index, const GLfloat* v), 2, 0, NULL, NULL) \
+    WIW_GL_FUNCTION(void, VertexAttribDivisor, (GLuint index, GLuint divisor), 3, 3, NULL, "GL_ARB_instanced_arrays") \
+    WIW_GL_FUNCTION(void, DrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount), 3, 1, NULL, "GL_ARB_draw_instanced") \
+    WIW_GL_FUNCTION(void*, MapBuffer, (GLenum target, GLenum access), 1, 5, NULL, "GL_ARB_vertex_buffer_object") \
+    WIW_GL_FUNCTION(GLboolean, UnmapBuffer, (GLenum target), 1, 5, NULL, "GL_ARB_vertex_buffer_object") \
+    WIW_GL_FUNCTION(GLsync, FenceSync, (GLenum condition, GLbitfield flags), 3, 2, "GL_ARB_sync", NULL) \
+    WIW_GL_FUNCTION(GLenum, ClientWaitSync, (GLsync sync, GLbitfield flags, GLuint64 timeout), 3, 2, "GL_ARB_sync", NULL) \
+    WIW_GL_FUNCTION(void, DeleteSync, (GLsync sync), 3, 2, "GL_ARB_sync", NULL) \
+    WIW_GL_FUNCTION(void, GenFencesNV, (GLsizei n, GLuint* fences), 0, 0, "GL_NV_fence", NULL) \
+    WIW_GL_FUNCTION(void, DeleteFencesNV, (GLsizei n, const GLuint* fences), 0, 0, "GL_NV_fence", NULL) \
+    WIW_GL_FUNCTION(void, SetFenceNV, (GLuint fence, GLenum condition), 0, 0, "GL_NV_fence", NULL) \
+    WIW_GL_FUNCTION(void, FinishFenceNV, (GLuint fence), 0, 0, "GL_NV_fence", NULL) \
+    WIW_GL_FUNCTION(void, GenFencesAPPLE, (GLsizei n, GLuint* fences), 0, 0, "GL_APPLE_fence", NULL) \
+    WIW_GL_FUNCTION(void, DeleteFencesAPPLE, (GLsizei n, const GLuint* fences), 0, 0, "GL_APPLE_fence", NULL) \
+    WIW_GL_FUNCTION(void, SetFenceAPPLE, (GLuint fence), 0, 0, "GL_APPLE_fence", NULL) \
+    WIW_GL_FUNCTION(void, FinishFenceAPPLE, (GLuint fence), 0, 0, "GL_APPLE_fence", NULL) \
+    WIW_GL_FUNCTION(void*, MapBufferRange, (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access), 3, 0, "GL_ARB_map_buffer_range", NULL) \
+    WIW_GL_FUNCTION(void, BufferStorage, (GLenum target, GLsizeiptr size, const void* data, GLbitfield flags), 4, 4, "GL_ARB_buffer_storage", NULL) \
+    WIW_GL_FUNCTION(void, GenQueries, (GLsizei n, GLuint* ids), 1, 5, NULL, "GL_ARB_occlusion_query") \
+    WIW_GL_FUNCTION(void, DeleteQueries, (GLsizei n, const GLuint* ids), 1, 5, NULL, "GL_ARB_occlusion_query") \
+    WIW_GL_FUNCTION(void, BeginQuery, (GLenum target, GLuint id), 1, 5, NULL, "GL_ARB_occlusion_query") \
+    WIW_GL_FUNCTION(void, EndQuery, (GLenum target), 1, 5, NULL, "GL_ARB_occlusion_query") \
+    WIW_GL_FUNCTION(void, GetQueryObjectui64v, (GLuint id, GLenum pname, GLuint64* params), 3, 3, "GL_ARB_timer_query", "GL_EXT_timer_query")
+
+#define WIW_GL_FUNCTION(ret, name, args, major, minor, core_ext, suffixed_ext) typedef ret (APIENTRY *WIW_PFN_##name) args;
+WIW_GL_FUNCTIONS
+#undef WIW_GL_FUNCTION
+
+typedef struct GLFunctionsStruct
+{
+#define WIW_GL_FUNCTION(ret, name, args, major, minor, core_ext, suffixed_ext) WIW_PFN_##name name;
+WIW_GL_FUNCTIONS
+#undef WIW_GL_FUNCTION
+} GLFunctions;
+
+typedef void (*GLProc)();
+GLProc GetGLProcAddress(const char* name);
+void LoadGLFunctions(GLFunctions* funcs);
+
+bool HasGLVersion(int major, int minor);
+bool HasGLExtension(const char* name);
+
+// Helpers for checks which need to render something and read it back.
+// Programs always get their position attribute at location 0 so glVertex
+// calls can feed them.
+GLuint CreateProgram(const char* vertex_source, const char* fragment_source, std::string* log);
+bool HasFramebufferObjects();
+
+typedef struct FramebufferStruct
+{
+  GLuint fbo;
+  GLuint tex;
+  int width, height;
+} Framebuffer;
+
+bool CreateFramebuffer(Framebuffer* fb, int width, int height, GLenum internal_format, GLenum format, GLenum type);
+void DestroyFramebuffer(Framebuffer* fb);
+void DrawFullscreenQuad();
+
 // Each check
 enum CheckResult {
     PASS,
@@ -100,9 +360,17 @@ enum CheckResult {
 // almost certainly won't work.
 
 CheckResult CheckInit();
+CheckResult CheckDirectRendering();
 CheckResult CheckDestroy();
 CheckResult CheckVersion();
 CheckResult CheckShaderVersion();
+CheckResult CheckMultisample();
+CheckResult CheckShaderPrecision();
+CheckResult CheckRendererInfo();
+CheckResult CheckRobustness();
+CheckResult CheckFloatTextures();
+CheckResult CheckDepthTextures();
+CheckResult RunBenchmarks();
 
 // To run tests, we make one long list and the main method just checks them in
 // order.
@@ -110,19 +378,97 @@ typedef CheckResult(*WebGLCheck)();
 WebGLCheck webgl_checks[] =
 {
     CheckInit,
+    CheckDirectRendering,
     CheckVersion,
     CheckShaderVersion,
+    CheckMultisample,
+    CheckShaderPrecision,
+    CheckRendererInfo,
+    CheckRobustness,
+    CheckFloatTextures,
+    CheckDepthTextures,
+    RunBenchmarks,
     CheckDestroy,
     NULL
 };
 
+// Benchmarks don't decide whether WebGL works, they measure how well it's
+// likely to run. They're only run when requested with --benchmark, after the
+// checks have passed, and just report their results.
+bool run_benchmarks = false;
+int benchmark_iterations = 100;
+// Measurement loops also stop after this many seconds, so slow (e.g. software)
+// renderers still finish in reasonable time.
+const double benchmark_time_limit = 2.0;
+
+bool KeepBenchmarking(int iteration, double start);
+
+void BenchmarkContextCreation();
+void BenchmarkFillRate();
+void BenchmarkDrawCalls();
+void BenchmarkTextureUpload();
+void BenchmarkReadback();
+void BenchmarkVertexStreaming();
+void BenchmarkShaderCompile();
+void BenchmarkClear();
+void BenchmarkStateChanges();
+void BenchmarkUniformUpdates();
+void BenchmarkInstancing();
+void BenchmarkBlending();
+void BenchmarkMipmapGeneration();
+void BenchmarkTextureSampling();
+void BenchmarkPingPong();
+void BenchmarkSyncLatency();
+void BenchmarkFloatTextures();
+void BenchmarkCompressedTextures();
+void BenchmarkShadowMap();
+
+typedef void(*WebGLBenchmark)();
+WebGLBenchmark webgl_benchmarks[] =
+{
+    BenchmarkContextCreation,
+    BenchmarkFillRate,
+    BenchmarkDrawCalls,
+    BenchmarkTextureUpload,
+    BenchmarkReadback,
+    BenchmarkVertexStreaming,
+    BenchmarkShaderCompile,
+    BenchmarkClear,
+    BenchmarkStateChanges,
+    BenchmarkUniformUpdates,
+    BenchmarkInstancing,
+    BenchmarkBlending,
+    BenchmarkMipmapGeneration,
+    BenchmarkTextureSampling,
+    BenchmarkPingPong,
+    BenchmarkSyncLatency,
+    BenchmarkFloatTextures,
+    BenchmarkCompressedTextures,
+    BenchmarkShadowMap,
+    NULL
+};
+
 GLContext ctx;
+GLFunctions gl;
 // Shared buffer for generating messages for convenience.
 char msg_buf[2048];
 
 
 int main(int argc, char** argv) {
     GLenum err;
+    bool warned = false;
+
+    for(int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--benchmark") == 0)
+            run_benchmarks = true;
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc && atoi(argv[i+1]) > 0)
+            benchmark_iterations = atoi(argv[++i]);
+        else {
+            sprintf(msg_buf, "Usage: %s [--benchmark [--iterations N]]", argv[0]);
+            ReportInfo("Usage", msg_buf);
+            return -1;
+        }
+    }
 
     for(WebGLCheck* check = webgl_checks; *check != NULL; check++) {
         CheckResult result = (*check)();
@@ -130,9 +476,14 @@ int main(int argc, char** argv) {
             DestroyContext(&ctx);
             return -1;
         }
+        if (result == WARNING)
+            warned = true;
     }
 
-    ReportInfo("WebGL should work!", "Passed all checks, you should be able to run WebGL!");
+    if (warned)
+        ReportInfo("WebGL should work!", "Passed all required checks, you should be able to run WebGL, but some features may be missing or slow.");
+    else
+        ReportInfo("WebGL should work!", "Passed all checks, you should be able to run WebGL!");
 
     return 0;
 }
@@ -183,6 +534,62 @@ void LoadURL(const std::string& url) {
 }
 #endif
 
+// Timing
+#if defined(_WIN32)
+
+double GetTime() {
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+}
+
+size_t GetResidentMemory() {
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.WorkingSetSize;
+}
+
+#elif defined(__APPLE__)
+
+double GetTime() {
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0)
+        mach_timebase_info(&timebase);
+    return (double)mach_absolute_time() * timebase.numer / timebase.denom * 1e-9;
+}
+
+size_t GetResidentMemory() {
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+}
+
+#else // Linux
+
+double GetTime() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+size_t GetResidentMemory() {
+    long pages_total, pages_resident;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL)
+        return 0;
+    int matched = fscanf(statm, "%ld %ld", &pages_total, &pages_resident);
+    fclose(statm);
+    if (matched < 2)
+        return 0;
+    return (size_t)pages_resident * sysconf(_SC_PAGESIZE);
+}
+
+#endif
+
 
 #if defined(_WIN32)
 
@@ -206,7 +613,7 @@ GLboolean CreateContext (GLContext* ctx)
   wc.hInstance = GetModuleHandle(NULL);
   wc.lpfnWndProc = DefWindowProc;
   wc.lpszClassName = "GLEW";
-  if (0 == RegisterClass(&wc)) return GL_TRUE;
+  if (0 == RegisterClass(&wc) && ERROR_CLASS_ALREADY_EXISTS != GetLastError()) return GL_TRUE;
   /* create window */
   ctx->wnd = CreateWindow("GLEW", "GLEW", 0, CW_USEDEFAULT, CW_USEDEFAULT,
                           CW_USEDEFAULT, CW_USEDEFAULT, NULL, NULL,
@@ -234,11 +641,43 @@ GLboolean CreateContext (GLContext* ctx)
   return GL_FALSE;
 }
 
+GLboolean CreateContextWithOptions (GLContext* ctx, const ContextOptions* options)
+{
+  /* no separate window system connection to reuse here */
+  if (options->robust || WINDOW_SURFACE != options->surface || NULL != options->connection) return GL_TRUE;
+  return CreateContext(ctx);
+}
+
+GLboolean CanCreateRobustContext (void)
+{
+  return GL_FALSE;
+}
+
+GLboolean MakeContextCurrent (GLContext* ctx)
+{
+  return wglMakeCurrent(ctx->dc, ctx->rc) ? GL_FALSE : GL_TRUE;
+}
+
+GLProc GetGLProcAddress (const char* name)
+{
+  return (GLProc)wglGetProcAddress(name);
+}
+
+GLboolean IsDirectContext (GLContext* ctx)
+{
+  return GL_TRUE;
+}
+
+GLboolean QueryRendererInfo (GLContext* ctx, RendererInfo* info)
+{
+  return GL_FALSE;
+}
+
 void DestroyContext (GLContext* ctx)
 {
   if (NULL == ctx) return;
-  if (NULL != ctx->rc) wglMakeCurrent(NULL, NULL);
-  if (NULL != ctx->rc) wglDeleteContext(wglGetCurrentContext());
+  if (NULL != ctx->rc && wglGetCurrentContext() == ctx->rc) wglMakeCurrent(NULL, NULL);
+  if (NULL != ctx->rc) wglDeleteContext(ctx->rc);
   if (NULL != ctx->wnd && NULL != ctx->dc) ReleaseDC(ctx->wnd, ctx->dc);
   if (NULL != ctx->wnd) DestroyWindow(ctx->wnd);
   UnregisterClass("GLEW", GetModuleHandle(NULL));
@@ -275,6 +714,38 @@ GLboolean CreateContext (GLContext* ctx)
   return GL_FALSE;
 }
 
+GLboolean CreateContextWithOptions (GLContext* ctx, const ContextOptions* options)
+{
+  /* no separate window system connection to reuse here */
+  if (options->robust || WINDOW_SURFACE != options->surface || NULL != options->connection) return GL_TRUE;
+  return CreateContext(ctx);
+}
+
+GLboolean CanCreateRobustContext (void)
+{
+  return GL_FALSE;
+}
+
+GLboolean MakeContextCurrent (GLContext* ctx)
+{
+  return aglSetCurrentContext(ctx->ctx) ? GL_FALSE : GL_TRUE;
+}
+
+GLProc GetGLProcAddress (const char* name)
+{
+  return (GLProc)dlsym(RTLD_DEFAULT, name);
+}
+
+GLboolean IsDirectContext (GLContext* ctx)
+{
+  return GL_TRUE;
+}
+
+GLboolean QueryRendererInfo (GLContext* ctx, RendererInfo* info)
+{
+  return GL_FALSE;
+}
+
 void DestroyContext (GLContext* ctx)
 {
   if (NULL == ctx) return;
@@ -295,6 +766,8 @@ void InitContext (GLContext* ctx)
   ctx->ctx = NULL;
   ctx->wnd = 0;
   ctx->cmap = 0;
+  ctx->pbuf = 0;
+  ctx->shared_dpy = false;
 }
 
 GLboolean CreateContext (GLContext* ctx)
@@ -329,17 +802,238 @@ GLboolean CreateContext (GLContext* ctx)
   return GL_FALSE;
 }
 
+#ifndef GLX_ARB_create_context_robustness
+#define GLX_CONTEXT_ROBUST_ACCESS_BIT_ARB            0x00000004
+#define GLX_LOSE_CONTEXT_ON_RESET_ARB                0x8252
+#define GLX_CONTEXT_RESET_NOTIFICATION_STRATEGY_ARB  0x8256
+#endif
+
+static bool HasGLXExtension (GLContext* ctx, const char* name);
+
+/* Failed context creation is reported as an X error, which would otherwise
+   kill the process. */
+static bool x_error = false;
+static int HandleXError (Display* dpy, XErrorEvent* ev)
+{
+  x_error = true;
+  return 0;
+}
+
+GLboolean CreateContextWithOptions (GLContext* ctx, const ContextOptions* options)
+{
+  int fb_attrib[] = { GLX_RENDER_TYPE, GLX_RGBA_BIT,
+                      GLX_DRAWABLE_TYPE, (PBUFFER_SURFACE == options->surface ? GLX_PBUFFER_BIT : GLX_WINDOW_BIT),
+                      None };
+  int pbuf_attrib[] = { GLX_PBUFFER_WIDTH, 1, GLX_PBUFFER_HEIGHT, 1, None };
+  int ctx_attrib[16];
+  int nattrib = 0;
+  PFNGLXCREATECONTEXTATTRIBSARBPROC create_context_attribs;
+  GLXFBConfig* configs;
+  GLXDrawable drawable = None;
+  int nconfigs;
+  XSetWindowAttributes swa;
+  Bool made_current;
+  int (*old_handler)(Display*, XErrorEvent*);
+  /* open display, or borrow another context's */
+  if (NULL != options->connection)
+  {
+    ctx->dpy = options->connection->dpy;
+    ctx->shared_dpy = true;
+  }
+  else
+    ctx->dpy = XOpenDisplay(display);
+  if (NULL == ctx->dpy) return GL_TRUE;
+  /* surfaceless and robust contexts need the attribs entry point */
+  if (options->robust)
+  {
+    if (!HasGLXExtension(ctx, "GLX_ARB_create_context_robustness")) return GL_TRUE;
+    ctx_attrib[nattrib++] = GLX_CONTEXT_FLAGS_ARB;
+    ctx_attrib[nattrib++] = GLX_CONTEXT_ROBUST_ACCESS_BIT_ARB;
+    ctx_attrib[nattrib++] = GLX_CONTEXT_RESET_NOTIFICATION_STRATEGY_ARB;
+    ctx_attrib[nattrib++] = GLX_LOSE_CONTEXT_ON_RESET_ARB;
+  }
+  if (NO_SURFACE == options->surface)
+  {
+    /* binding no drawable is only allowed for GL 3.0 and later contexts */
+    ctx_attrib[nattrib++] = GLX_CONTEXT_MAJOR_VERSION_ARB;
+    ctx_attrib[nattrib++] = 3;
+    ctx_attrib[nattrib++] = GLX_CONTEXT_MINOR_VERSION_ARB;
+    ctx_attrib[nattrib++] = 0;
+  }
+  ctx_attrib[nattrib] = None;
+  create_context_attribs = NULL;
+  if (0 != nattrib)
+  {
+    if (!HasGLXExtension(ctx, "GLX_ARB_create_context")) return GL_TRUE;
+    create_context_attribs = (PFNGLXCREATECONTEXTATTRIBSARBPROC)GetGLProcAddress("glXCreateContextAttribsARB");
+    if (NULL == create_context_attribs) return GL_TRUE;
+  }
+  /* choose config */
+  configs = glXChooseFBConfig(ctx->dpy, DefaultScreen(ctx->dpy), fb_attrib, &nconfigs);
+  if (NULL == configs || 0 == nconfigs)
+  {
+    if (NULL != configs) XFree(configs);
+    return GL_TRUE;
+  }
+  /* creating the context, the drawable and binding them can all fail with
+     an X error, e.g. BadMatch without pbuffer or surfaceless support */
+  x_error = false;
+  old_handler = XSetErrorHandler(HandleXError);
+  /* create context */
+  if (NULL != create_context_attribs)
+    ctx->ctx = create_context_attribs(ctx->dpy, configs[0], NULL, True, ctx_attrib);
+  else
+    ctx->ctx = glXCreateNewContext(ctx->dpy, configs[0], GLX_RGBA_TYPE, NULL, True);
+  XSync(ctx->dpy, False);
+  if (NULL == ctx->ctx || x_error)
+  {
+    XSetErrorHandler(old_handler);
+    XFree(configs);
+    return GL_TRUE;
+  }
+  /* create drawable */
+  if (WINDOW_SURFACE == options->surface)
+  {
+    ctx->vi = glXGetVisualFromFBConfig(ctx->dpy, configs[0]);
+    if (NULL == ctx->vi)
+    {
+      XSetErrorHandler(old_handler);
+      XFree(configs);
+      return GL_TRUE;
+    }
+    ctx->cmap = XCreateColormap(ctx->dpy, RootWindow(ctx->dpy, ctx->vi->screen),
+                                ctx->vi->visual, AllocNone);
+    swa.border_pixel = 0;
+    swa.colormap = ctx->cmap;
+    ctx->wnd = XCreateWindow(ctx->dpy, RootWindow(ctx->dpy, ctx->vi->screen),
+                             0, 0, 1, 1, 0, ctx->vi->depth, InputOutput, ctx->vi->visual,
+                             CWBorderPixel | CWColormap, &swa);
+    drawable = ctx->wnd;
+  }
+  else if (PBUFFER_SURFACE == options->surface)
+  {
+    ctx->pbuf = glXCreatePbuffer(ctx->dpy, configs[0], pbuf_attrib);
+    drawable = ctx->pbuf;
+  }
+  XFree(configs);
+  XSync(ctx->dpy, False);
+  if (x_error)
+  {
+    /* the id of a drawable that failed doesn't name anything to destroy */
+    ctx->wnd = 0;
+    ctx->pbuf = 0;
+    XSetErrorHandler(old_handler);
+    return GL_TRUE;
+  }
+  /* make context current */
+  made_current = glXMakeContextCurrent(ctx->dpy, drawable, drawable, ctx->ctx);
+  XSync(ctx->dpy, False);
+  XSetErrorHandler(old_handler);
+  if (!made_current || x_error) return GL_TRUE;
+  return GL_FALSE;
+}
+
+GLboolean CanCreateRobustContext (void)
+{
+  return GL_TRUE;
+}
+
+GLboolean MakeContextCurrent (GLContext* ctx)
+{
+  GLXDrawable drawable = (0 != ctx->wnd ? ctx->wnd : ctx->pbuf);
+  return glXMakeContextCurrent(ctx->dpy, drawable, drawable, ctx->ctx) ? GL_FALSE : GL_TRUE;
+}
+
+GLProc GetGLProcAddress (const char* name)
+{
+  return (GLProc)glXGetProcAddressARB((const GLubyte*)name);
+}
+
+GLboolean IsDirectContext (GLContext* ctx)
+{
+  return glXIsDirect(ctx->dpy, ctx->ctx) ? GL_TRUE : GL_FALSE;
+}
+
+#ifndef GLX_MESA_query_renderer
+#define GLX_RENDERER_VENDOR_ID_MESA                    0x8183
+#define GLX_RENDERER_DEVICE_ID_MESA                    0x8184
+#define GLX_RENDERER_ACCELERATED_MESA                  0x8186
+#define GLX_RENDERER_VIDEO_MEMORY_MESA                 0x8187
+#define GLX_RENDERER_UNIFIED_MEMORY_ARCHITECTURE_MESA  0x8188
+typedef Bool (*PFNGLXQUERYCURRENTRENDERERINTEGERMESAPROC) (int attribute, unsigned int *value);
+typedef const char* (*PFNGLXQUERYCURRENTRENDERERSTRINGMESAPROC) (int attribute);
+#endif
+
+static bool HasGLXExtension (GLContext* ctx, const char* name)
+{
+  const char* exts = glXQueryExtensionsString(ctx->dpy, DefaultScreen(ctx->dpy));
+  if (NULL == exts) return false;
+  size_t len = strlen(name);
+  for (const char* pos = strstr(exts, name); pos != NULL; pos = strstr(pos + len, name))
+    if ((pos == exts || pos[-1] == ' ') && (pos[len] == ' ' || pos[len] == '\0')) return true;
+  return false;
+}
+
+GLboolean QueryRendererInfo (GLContext* ctx, RendererInfo* info)
+{
+  PFNGLXQUERYCURRENTRENDERERINTEGERMESAPROC query_integer;
+  PFNGLXQUERYCURRENTRENDERERSTRINGMESAPROC query_string;
+  unsigned int value;
+  const char* str;
+  if (!HasGLXExtension(ctx, "GLX_MESA_query_renderer")) return GL_FALSE;
+  query_integer = (PFNGLXQUERYCURRENTRENDERERINTEGERMESAPROC)GetGLProcAddress("glXQueryCurrentRendererIntegerMESA");
+  query_string = (PFNGLXQUERYCURRENTRENDERERSTRINGMESAPROC)GetGLProcAddress("glXQueryCurrentRendererStringMESA");
+  if (NULL == query_integer || NULL == query_string) return GL_FALSE;
+  if (query_integer(GLX_RENDERER_VENDOR_ID_MESA, &value)) info->vendor_id = value;
+  if (query_integer(GLX_RENDERER_DEVICE_ID_MESA, &value)) info->device_id = value;
+  if (query_integer(GLX_RENDERER_VIDEO_MEMORY_MESA, &value)) info->video_memory_mb = value;
+  if (query_integer(GLX_RENDERER_ACCELERATED_MESA, &value)) info->accelerated = (value != 0);
+  if (query_integer(GLX_RENDERER_UNIFIED_MEMORY_ARCHITECTURE_MESA, &value)) info->unified_memory = (value != 0);
+  if (NULL != (str = query_string(GLX_RENDERER_VENDOR_ID_MESA))) info->vendor = str;
+  if (NULL != (str = query_string(GLX_RENDERER_DEVICE_ID_MESA))) info->device = str;
+  return GL_TRUE;
+}
+
 void DestroyContext (GLContext* ctx)
 {
+  /* a borrowed connection stays open, so release the context explicitly */
+  if (NULL != ctx->dpy && ctx->shared_dpy && glXGetCurrentContext() == ctx->ctx) glXMakeContextCurrent(ctx->dpy, None, None, NULL);
   if (NULL != ctx->dpy && NULL != ctx->ctx) glXDestroyContext(ctx->dpy, ctx->ctx);
   if (NULL != ctx->dpy && 0 != ctx->wnd) XDestroyWindow(ctx->dpy, ctx->wnd);
+  if (NULL != ctx->dpy && 0 != ctx->pbuf) glXDestroyPbuffer(ctx->dpy, ctx->pbuf);
   if (NULL != ctx->dpy && 0 != ctx->cmap) XFreeColormap(ctx->dpy, ctx->cmap);
   if (NULL != ctx->vi) XFree(ctx->vi);
-  if (NULL != ctx->dpy) XCloseDisplay(ctx->dpy);
+  if (NULL != ctx->dpy && !ctx->shared_dpy) XCloseDisplay(ctx->dpy);
 }
 
 #endif /* __UNIX || (__APPLE__ && GLEW_APPLE_GLX) */
 
+static GLProc LoadGLFunction(const char* name, int major, int minor, const char* core_ext, const char* suffixed_ext) {
+    if ((major > 0 && HasGLVersion(major, minor)) || (core_ext != NULL && HasGLExtension(core_ext)))
+        return GetGLProcAddress(name);
+    if (suffixed_ext != NULL && HasGLExtension(suffixed_ext)) {
+        // The suffix is the extension's vendor prefix, e.g. GL_EXT_... -> EXT.
+        const char* vendor = suffixed_ext + 3;
+        std::string suffix(vendor, strchr(vendor, '_') - vendor);
+        return GetGLProcAddress((std::string(name) + suffix).c_str());
+    }
+    // Not advertised, whatever comes back mustn't be called.
+    return GetGLProcAddress(name);
+}
+
+void LoadGLFunctions(GLFunctions* funcs) {
+#define WIW_GL_FUNCTION(ret, name, args, major, minor, core_ext, suffixed_ext) \
+    funcs->name = (WIW_PFN_##name)LoadGLFunction("gl" #name, major, minor, core_ext, suffixed_ext);
+WIW_GL_FUNCTIONS
+#undef WIW_GL_FUNCTION
+}
+
+void InitContextOptions (ContextOptions* options) {
+    options->robust = false;
+    options->surface = WINDOW_SURFACE;
+    options->connection = NULL;
+}
+
 
 CheckResult CheckInit() {
     InitContext(&ctx);
@@ -350,6 +1044,10 @@ CheckResult CheckInit() {
         return FAIL;
     }
 
+    // Function pointers may be specific to the context on some platforms, so
+    // they can only be loaded once it is current.
+    LoadGLFunctions(&gl);
+
     return PASS;
 }
 
@@ -358,6 +1056,73 @@ CheckResult CheckDestroy() {
     return PASS;
 }
 
+CheckResult RunBenchmarks() {
+    if (!run_benchmarks)
+        return PASS;
+
+    ReportInfo("Benchmark", HasTimerQueries() ?
+        "GPU times are measured with timer queries." :
+        "Timer queries aren't available, GPU times are averaged over each run with a single glFinish and include CPU time.");
+
+    for(WebGLBenchmark* benchmark = webgl_benchmarks; *benchmark != NULL; benchmark++)
+        (*benchmark)();
+    return PASS;
+}
+
+// Indirect contexts (e.g. GLX over a remote X connection) technically run
+// WebGL, but every query is a protocol round trip and every command is
+// serialized over the connection, which is usually too slow to be usable.
+CheckResult CheckDirectRendering() {
+    if (IsDirectContext(&ctx))
+        return PASS;
+
+    const int query_iterations = 1000;
+    const int command_iterations = 100000;
+    const int upload_iterations = 16;
+    const int upload_size = 256;
+
+    // Queries need a reply, so each one costs a full round trip.
+    glFinish();
+    double start = GetTime();
+    GLint value;
+    for(int i = 0; i < query_iterations; i++)
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &value);
+    double query_us = (GetTime() - start) * 1e6 / query_iterations;
+
+    // Rendering commands are batched, so this measures protocol throughput.
+    start = GetTime();
+    glBegin(GL_POINTS);
+    for(int i = 0; i < command_iterations; i++)
+        glVertex2f(0.f, 0.f);
+    glEnd();
+    glFinish();
+    double commands_per_sec = command_iterations / (GetTime() - start);
+
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    unsigned char* data = new unsigned char[upload_size * upload_size * 4];
+    memset(data, 0, upload_size * upload_size * 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, upload_size, upload_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glFinish();
+    start = GetTime();
+    for(int i = 0; i < upload_iterations; i++)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, upload_size, upload_size, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glFinish();
+    double upload_mb_per_sec = (double)upload_iterations * upload_size * upload_size * 4 / (GetTime() - start) / (1024 * 1024);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &tex);
+    delete[] data;
+
+    sprintf(msg_buf, "Warning: The OpenGL context is indirect, WebGL will be very slow.\n"
+        "Query round trip: %.1f us\n"
+        "Command throughput: %.0f calls/s\n"
+        "Texture upload: %.1f MB/s",
+        query_us, commands_per_sec, upload_mb_per_sec);
+    ReportInfo("Warning", msg_buf);
+    return WARNING;
+}
+
 // Helper method for checking versions.  Tries to parse the beginning of a
 // string as a version number, returning a .
 bool ParseVersion(const char* str, int* major, int* minor) {
@@ -426,3 +1191,3614 @@ CheckResult CheckShaderVersion() {
 
     return PASS;
 }
+
+bool HasGLVersion(int major, int minor) {
+    int have_major, have_minor;
+    const char* vers = (const char*)glGetString(GL_VERSION);
+    if (vers == NULL || !ParseVersion(vers, &have_major, &have_minor))
+        return false;
+    return (have_major > major ||
+        (have_major == major && have_minor >= minor));
+}
+
+bool HasGLExtension(const char* name) {
+    const char* exts = (const char*)glGetString(GL_EXTENSIONS);
+    if (exts == NULL)
+        return false;
+    // Match whole names only, GL_EXT_foo shouldn't match GL_EXT_foo_bar.
+    size_t len = strlen(name);
+    for(const char* pos = strstr(exts, name); pos != NULL; pos = strstr(pos + len, name)) {
+        if ((pos == exts || pos[-1] == ' ') && (pos[len] == ' ' || pos[len] == '\0'))
+            return true;
+    }
+    return false;
+}
+
+GLuint CompileShader(GLenum type, const char* source, std::string* log) {
+    GLuint shader = gl.CreateShader(type);
+    gl.ShaderSource(shader, 1, &source, NULL);
+    gl.CompileShader(shader);
+    GLint compiled = GL_FALSE;
+    gl.GetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    if (compiled != GL_TRUE) {
+        if (log) {
+            GLchar info[1024];
+            gl.GetShaderInfoLog(shader, sizeof(info), NULL, info);
+            *log = info;
+        }
+        gl.DeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLuint CreateProgram(const char* vertex_source, const char* fragment_source, std::string* log) {
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, vertex_source, log);
+    if (vs == 0)
+        return 0;
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragment_source, log);
+    if (fs == 0) {
+        gl.DeleteShader(vs);
+        return 0;
+    }
+
+    GLuint program = gl.CreateProgram();
+    gl.AttachShader(program, vs);
+    gl.AttachShader(program, fs);
+    gl.BindAttribLocation(program, 0, "position");
+    gl.LinkProgram(program);
+    // The program keeps the shaders alive as long as it needs them.
+    gl.DeleteShader(vs);
+    gl.DeleteShader(fs);
+
+    GLint linked = GL_FALSE;
+    gl.GetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (linked != GL_TRUE) {
+        if (log) {
+            GLchar info[1024];
+            gl.GetProgramInfoLog(program, sizeof(info), NULL, info);
+            *log = info;
+        }
+        gl.DeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+bool HasFramebufferObjects() {
+    return HasGLVersion(3, 0) || HasGLExtension("GL_ARB_framebuffer_object") ||
+        HasGLExtension("GL_EXT_framebuffer_object");
+}
+
+// Creates a framebuffer with a single texture color attachment and leaves it
+// bound. Returns false if the driver can't render to the format.
+bool CreateFramebuffer(Framebuffer* fb, int width, int height, GLenum internal_format, GLenum format, GLenum type) {
+    fb->width = width;
+    fb->height = height;
+    glGenTextures(1, &fb->tex);
+    glBindTexture(GL_TEXTURE_2D, fb->tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, type, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl.GenFramebuffers(1, &fb->fbo);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, fb->fbo);
+    gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fb->tex, 0);
+    glViewport(0, 0, width, height);
+    return (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+}
+
+void DestroyFramebuffer(Framebuffer* fb) {
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl.DeleteFramebuffers(1, &fb->fbo);
+    glDeleteTextures(1, &fb->tex);
+    fb->fbo = 0;
+    fb->tex = 0;
+}
+
+// Vertex shader shared by checks and benchmarks which just cover the viewport.
+static const char* fullscreen_vertex_shader =
+    "#version 120\n"
+    "attribute vec4 position;\n"
+    "varying vec2 uv;\n"
+    "void main() {\n"
+    "    uv = position.xy * 0.5 + 0.5;\n"
+    "    gl_Position = position;\n"
+    "}\n";
+
+static const char* trivial_fragment_shader =
+    "#version 120\n"
+    "void main() { gl_FragColor = vec4(0.2, 0.4, 0.6, 1.0); }\n";
+
+static const char* textured_fragment_shader =
+    "#version 120\n"
+    "uniform sampler2D tex;\n"
+    "varying vec2 uv;\n"
+    "void main() { gl_FragColor = texture2D(tex, uv); }\n";
+
+void DrawFullscreenQuad() {
+    glBegin(GL_TRIANGLE_STRIP);
+    glVertex2f(-1.f, -1.f);
+    glVertex2f(1.f, -1.f);
+    glVertex2f(-1.f, 1.f);
+    glVertex2f(1.f, 1.f);
+    glEnd();
+}
+
+// Browsers antialias WebGL canvases by default, but a driver can advertise
+// GL_MAX_SAMPLES and then silently give back fewer samples (or none). For each
+// sample count we render a slanted edge into a multisampled renderbuffer,
+// resolve it, and look for partially covered pixels along the edge.
+CheckResult CheckMultisample() {
+    const int size = 512;
+    const int resolve_iterations = 16;
+
+    if (!HasGLVersion(3, 0) && !HasGLExtension("GL_ARB_framebuffer_object") &&
+        !(HasGLExtension("GL_EXT_framebuffer_object") && HasGLExtension("GL_EXT_framebuffer_multisample") &&
+          HasGLExtension("GL_EXT_framebuffer_blit"))) {
+        ReportInfo("Warning", "Warning: Multisampled framebuffers aren't supported, WebGL won't be antialiased.");
+        return WARNING;
+    }
+
+    GLint max_samples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &max_samples);
+    if (max_samples < 2) {
+        sprintf(msg_buf, "Warning: GL_MAX_SAMPLES is %d, WebGL won't be antialiased.", max_samples);
+        ReportInfo("Warning", msg_buf);
+        return WARNING;
+    }
+
+    // Single sampled target to resolve into and read back from.
+    GLuint resolve_fbo, resolve_rb;
+    gl.GenFramebuffers(1, &resolve_fbo);
+    gl.GenRenderbuffers(1, &resolve_rb);
+    gl.BindRenderbuffer(GL_RENDERBUFFER, resolve_rb);
+    gl.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, resolve_fbo);
+    gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolve_rb);
+
+    unsigned char* pixels = new unsigned char[size * size * 4];
+    std::string report;
+    CheckResult result = PASS;
+
+    // Walk the power of two sample counts, plus the maximum if it isn't one.
+    for(int samples = 2; ; samples *= 2) {
+        if (samples > max_samples)
+            samples = max_samples;
+
+        GLuint ms_fbo, ms_rb;
+        gl.GenFramebuffers(1, &ms_fbo);
+        gl.GenRenderbuffers(1, &ms_rb);
+        gl.BindRenderbuffer(GL_RENDERBUFFER, ms_rb);
+        gl.RenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, size, size);
+        GLint actual_samples = 0;
+        gl.GetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_SAMPLES, &actual_samples);
+        gl.BindFramebuffer(GL_FRAMEBUFFER, ms_fbo);
+        gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, ms_rb);
+
+        if (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            sprintf(msg_buf, "%dx: framebuffer incomplete\n", samples);
+            report += msg_buf;
+            result = WARNING;
+        }
+        else {
+            // A white triangle on black, with an edge that isn't aligned to
+            // the pixel grid or to 45 degrees so it gets a spread of coverage.
+            glViewport(0, 0, size, size);
+            glEnable(GL_MULTISAMPLE);
+            glClearColor(0.f, 0.f, 0.f, 1.f);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glColor3f(1.f, 1.f, 1.f);
+            glBegin(GL_TRIANGLES);
+            glVertex2f(-1.f, -1.f);
+            glVertex2f(1.f, -1.f);
+            glVertex2f(-1.f, 0.9f);
+            glEnd();
+
+            gl.BindFramebuffer(GL_READ_FRAMEBUFFER, ms_fbo);
+            gl.BindFramebuffer(GL_DRAW_FRAMEBUFFER, resolve_fbo);
+            glFinish();
+            double start = GetTime();
+            for(int i = 0; i < resolve_iterations; i++)
+                gl.BlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glFinish();
+            double resolve_ms = (GetTime() - start) * 1000.0 / resolve_iterations;
+
+            gl.BindFramebuffer(GL_FRAMEBUFFER, resolve_fbo);
+            glReadPixels(0, 0, size, size, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            int partial = 0;
+            for(int i = 0; i < size * size; i++) {
+                if (pixels[i*4] > 8 && pixels[i*4] < 247)
+                    partial++;
+            }
+
+            sprintf(msg_buf, "%dx: got %d samples, %d antialiased edge pixels, %.3f ms per %dx%d resolve\n",
+                samples, actual_samples, partial, resolve_ms, size, size);
+            report += msg_buf;
+            if (partial == 0 || actual_samples < samples)
+                result = WARNING;
+        }
+
+        gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+        gl.DeleteFramebuffers(1, &ms_fbo);
+        gl.DeleteRenderbuffers(1, &ms_rb);
+
+        if (samples == max_samples)
+            break;
+    }
+
+    gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+    gl.DeleteFramebuffers(1, &resolve_fbo);
+    gl.DeleteRenderbuffers(1, &resolve_rb);
+    delete[] pixels;
+
+    if (result == WARNING)
+        ReportInfo("Warning", "Warning: Multisampling doesn't work at every advertised sample count, WebGL antialiasing may be unavailable.\n" + report);
+    else
+        ReportInfo("Multisampling", report);
+    return result;
+}
+
+// Shader functions which measure float precision by brute force. All the
+// constants come from uniforms (one = 1, two = 2, one_half = 0.5) since compilers
+// are allowed to fold or reassociate expressions like (one + e == one) and
+// would otherwise report their own precision. Each result is a small integer
+// so it survives an RGBA8 target: mantissa bits, largest power of two exponent
+// and smallest power of two exponent before underflow.
+static const char* precision_probe_functions =
+    "uniform float one;\n"
+    "uniform float two;\n"
+    "uniform float one_half;\n"
+    "float MantissaBits() {\n"
+    "    float bits = 0.0;\n"
+    "    float e = one;\n"
+    "    for (int i = 0; i < 64; i++) {\n"
+    "        e *= one_half;\n"
+    "        if (one + e == two * one_half) break;\n"
+    "        bits += 1.0;\n"
+    "    }\n"
+    "    return bits;\n"
+    "}\n"
+    "float MaxExponent() {\n"
+    "    float bits = 0.0;\n"
+    "    float x = one;\n"
+    "    for (int i = 0; i < 254; i++) {\n"
+    "        float y = x * two;\n"
+    "        if (y * one_half != x) break;\n"
+    "        x = y;\n"
+    "        bits += 1.0;\n"
+    "    }\n"
+    "    return bits;\n"
+    "}\n"
+    "float MinExponent() {\n"
+    "    float bits = 0.0;\n"
+    "    float x = one;\n"
+    "    for (int i = 0; i < 254; i++) {\n"
+    "        float y = x * one_half;\n"
+    "        if (y * two != x) break;\n"
+    "        x = y;\n"
+    "        bits += 1.0;\n"
+    "    }\n"
+    "    return bits;\n"
+    "}\n"
+    "vec4 Probe() {\n"
+    "    return vec4(MantissaBits(), MaxExponent(), MinExponent(), 0.0) / 255.0;\n"
+    "}\n";
+
+// Runs the probe in one stage and reads the results back. Returns false if
+// the probe couldn't be compiled or rendered.
+static bool RunPrecisionProbe(bool in_vertex_shader, int* mantissa, int* max_exp, int* min_exp) {
+    std::string vs = "#version 120\n";
+    std::string fs = "#version 120\n";
+    if (in_vertex_shader) {
+        vs += precision_probe_functions;
+        vs += "attribute vec4 position;\n"
+            "varying vec4 result;\n"
+            "void main() { result = Probe(); gl_Position = position; }\n";
+        fs += "varying vec4 result;\n"
+            "void main() { gl_FragColor = result; }\n";
+    }
+    else {
+        vs += "attribute vec4 position;\n"
+            "void main() { gl_Position = position; }\n";
+        fs += precision_probe_functions;
+        fs += "void main() { gl_FragColor = Probe(); }\n";
+    }
+
+    GLuint program = CreateProgram(vs.c_str(), fs.c_str(), NULL);
+    if (program == 0)
+        return false;
+
+    Framebuffer fb;
+    bool result = CreateFramebuffer(&fb, 4, 4, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    if (result) {
+        gl.UseProgram(program);
+        gl.Uniform1f(gl.GetUniformLocation(program, "one"), 1.f);
+        gl.Uniform1f(gl.GetUniformLocation(program, "two"), 2.f);
+        gl.Uniform1f(gl.GetUniformLocation(program, "one_half"), 0.5f);
+        DrawFullscreenQuad();
+        gl.UseProgram(0);
+
+        unsigned char pixel[4];
+        glReadPixels(1, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        *mantissa = pixel[0];
+        *max_exp = pixel[1];
+        *min_exp = pixel[2];
+    }
+    DestroyFramebuffer(&fb);
+    gl.DeleteProgram(program);
+    return result;
+}
+
+// WebGL content generally assumes highp works in fragment shaders. Report
+// what the driver claims through glGetShaderPrecisionFormat, then measure what
+// actually happens in each stage.
+CheckResult CheckShaderPrecision() {
+    // OpenGL ES 2.0 only requires highp to have a relative precision of 2^-16
+    // and a range of 2^62.
+    const int required_mantissa = 16, required_exp = 62;
+
+    std::string report;
+    CheckResult result = PASS;
+
+    if (HasGLVersion(4, 1) || HasGLExtension("GL_ARB_ES2_compatibility")) {
+        static const GLenum stages[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+        static const char* stage_names[] = { "vertex", "fragment" };
+        static const GLenum types[] = { GL_LOW_FLOAT, GL_MEDIUM_FLOAT, GL_HIGH_FLOAT, GL_LOW_INT, GL_MEDIUM_INT, GL_HIGH_INT };
+        static const char* type_names[] = { "lowp float", "mediump float", "highp float", "lowp int", "mediump int", "highp int" };
+        for(int s = 0; s < 2; s++) {
+            for(int t = 0; t < 6; t++) {
+                GLint range[2] = { 0, 0 }, precision = 0;
+                gl.GetShaderPrecisionFormat(stages[s], types[t], range, &precision);
+                sprintf(msg_buf, "Reported %s %s: range -2^%d..2^%d, precision 2^-%d\n",
+                    stage_names[s], type_names[t], range[0], range[1], precision);
+                report += msg_buf;
+            }
+        }
+    }
+    else {
+        report += "glGetShaderPrecisionFormat not available, measured values only.\n";
+    }
+
+    if (!HasFramebufferObjects()) {
+        report += "Framebuffer objects not available, couldn't measure precision.\n";
+        ReportInfo("Shader precision", report);
+        return WARNING;
+    }
+
+    for(int stage = 0; stage < 2; stage++) {
+        const char* stage_name = (stage == 0 ? "vertex" : "fragment");
+        int mantissa = 0, max_exp = 0, min_exp = 0;
+        if (!RunPrecisionProbe(stage == 0, &mantissa, &max_exp, &min_exp)) {
+            sprintf(msg_buf, "Measured %s float: probe failed\n", stage_name);
+            report += msg_buf;
+            result = WARNING;
+            continue;
+        }
+        sprintf(msg_buf, "Measured %s float: range 2^-%d..2^%d, precision 2^-%d\n",
+            stage_name, min_exp, max_exp, mantissa);
+        report += msg_buf;
+        if (mantissa < required_mantissa || max_exp < required_exp)
+            result = WARNING;
+    }
+
+    if (result == WARNING)
+        ReportInfo("Warning", "Warning: highp floats may not be fully supported, precision sensitive WebGL content may break.\n" + report);
+    else
+        ReportInfo("Shader precision", report);
+    return result;
+}
+
+// Collects what we know about the device and how much memory it has, which
+// limits how many WebGL contexts can share it. The window system query gives
+// identity and total memory, the vendor GL extensions give what's available.
+CheckResult CheckRendererInfo() {
+    std::string report;
+    CheckResult result = PASS;
+
+    sprintf(msg_buf, "GL_VENDOR: %s\nGL_RENDERER: %s\n",
+        (const char*)glGetString(GL_VENDOR), (const char*)glGetString(GL_RENDERER));
+    report += msg_buf;
+
+    RendererInfo info;
+    info.vendor_id = info.device_id = info.video_memory_mb = 0;
+    info.accelerated = info.unified_memory = false;
+    if (QueryRendererInfo(&ctx, &info)) {
+        sprintf(msg_buf, "Device: %s %s (%04x:%04x)\nVideo memory: %u MB\nAccelerated: %s\nUnified memory: %s\n",
+            info.vendor.c_str(), info.device.c_str(), info.vendor_id, info.device_id,
+            info.video_memory_mb, info.accelerated ? "yes" : "no", info.unified_memory ? "yes" : "no");
+        report += msg_buf;
+        if (!info.accelerated)
+            result = WARNING;
+    }
+
+    // Both of these report in kB.
+    if (HasGLExtension("GL_NVX_gpu_memory_info")) {
+        GLint dedicated = 0, total = 0, available = 0;
+        glGetIntegerv(GL_GPU_MEMORY_INFO_DEDICATED_VIDMEM_NVX, &dedicated);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_TOTAL_AVAILABLE_MEMORY_NVX, &total);
+        glGetIntegerv(GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX, &available);
+        sprintf(msg_buf, "NVX dedicated: %d MB, total available: %d MB, currently available: %d MB\n",
+            dedicated / 1024, total / 1024, available / 1024);
+        report += msg_buf;
+    }
+    if (HasGLExtension("GL_ATI_meminfo")) {
+        // The first value of each is the total free memory in the pool.
+        GLint vbo[4] = { 0 }, tex[4] = { 0 }, rb[4] = { 0 };
+        glGetIntegerv(GL_VBO_FREE_MEMORY_ATI, vbo);
+        glGetIntegerv(GL_TEXTURE_FREE_MEMORY_ATI, tex);
+        glGetIntegerv(GL_RENDERBUFFER_FREE_MEMORY_ATI, rb);
+        sprintf(msg_buf, "ATI free VBO memory: %d MB, texture: %d MB, renderbuffer: %d MB\n",
+            vbo[0] / 1024, tex[0] / 1024, rb[0] / 1024);
+        report += msg_buf;
+    }
+
+    if (result == WARNING)
+        ReportInfo("Warning", "Warning: The renderer isn't hardware accelerated, WebGL may be slow.\n" + report);
+    else
+        ReportInfo("Renderer", report);
+    return result;
+}
+
+// Browsers only enable WebGL (or enable it without extra restrictions) when
+// they can get a robust context and find out about GPU resets. We check the
+// extensions in the default context, then try to create a robust context with
+// reset notification and make sure the reset status can actually be queried.
+CheckResult CheckRobustness() {
+    std::string report;
+    bool have_robustness = HasGLExtension("GL_ARB_robustness") || HasGLExtension("GL_KHR_robustness");
+    sprintf(msg_buf, "GL_ARB_robustness: %s\nGL_KHR_robustness: %s\n",
+        HasGLExtension("GL_ARB_robustness") ? "yes" : "no",
+        HasGLExtension("GL_KHR_robustness") ? "yes" : "no");
+    report += msg_buf;
+
+    if (GL_FALSE == CanCreateRobustContext()) {
+        report += "Robust context with reset notification: not checked on this platform\n";
+        if (!have_robustness) {
+            ReportInfo("Warning", "Warning: Robust contexts aren't supported, browsers may restrict WebGL or stall after GPU resets.\n" + report);
+            return WARNING;
+        }
+        ReportInfo("Robustness", report);
+        return PASS;
+    }
+
+    GLContext robust_ctx;
+    InitContext(&robust_ctx);
+    ContextOptions options;
+    InitContextOptions(&options);
+    options.robust = true;
+    bool created = (GL_FALSE == CreateContextWithOptions(&robust_ctx, &options));
+
+    bool notifies = false, usable = false;
+    if (created) {
+        // Entry points can be context specific, so look them up again.
+        GLFunctions robust_gl;
+        LoadGLFunctions(&robust_gl);
+        GLint strategy = 0, flags = 0;
+        glGetIntegerv(GL_RESET_NOTIFICATION_STRATEGY_ARB, &strategy);
+        if (HasGLVersion(3, 0))
+            glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+        // A context which never reports resets is no better than none.
+        notifies = (strategy == GL_LOSE_CONTEXT_ON_RESET_ARB);
+        report += notifies ? "Robust context with reset notification: created\n" :
+            "Robust context: created, but without reset notification\n";
+        sprintf(msg_buf, "Reset notification strategy: %s\nRobust access: %s\n",
+            strategy == GL_LOSE_CONTEXT_ON_RESET_ARB ? "lose context on reset" : "no reset notification",
+            (flags & GL_CONTEXT_FLAG_ROBUST_ACCESS_BIT_ARB) ? "yes" : "no");
+        report += msg_buf;
+
+        if (HasGLExtension("GL_ARB_robustness") || HasGLExtension("GL_KHR_robustness") || HasGLVersion(4, 5)) {
+            // Nothing should have reset, so this has to come back clean.
+            GLenum status = robust_gl.GetGraphicsResetStatus();
+            GLenum error = glGetError();
+            usable = (status == GL_NO_ERROR && error == GL_NO_ERROR);
+            sprintf(msg_buf, "glGetGraphicsResetStatus: 0x%04x%s\n", status, usable ? "" : " (unusable)");
+            report += msg_buf;
+        }
+    }
+    else {
+        report += "Robust context with reset notification: couldn't be created\n";
+    }
+
+    // Rebind ctx first, so it's never left without a current context.
+    MakeContextCurrent(&ctx);
+    DestroyContext(&robust_ctx);
+
+    if (!have_robustness || !created || !notifies || !usable) {
+        ReportInfo("Warning", "Warning: Robust contexts aren't fully supported, browsers may restrict WebGL or stall after GPU resets.\n" + report);
+        return WARNING;
+    }
+    ReportInfo("Robustness", report);
+    return PASS;
+}
+
+// Float texture formats, the desktop equivalents of OES_texture_half_float and
+// OES_texture_float.
+typedef struct FloatFormatStruct
+{
+  const char* name;
+  GLenum internal_format;
+  GLenum type;
+} FloatFormat;
+
+static const FloatFormat float_formats[] = {
+    { "RGBA16F", GL_RGBA16F, GL_HALF_FLOAT },
+    { "RGBA32F", GL_RGBA32F, GL_FLOAT },
+};
+static const int num_float_formats = sizeof(float_formats) / sizeof(float_formats[0]);
+
+bool HasFloatTextures() {
+    return HasGLVersion(3, 0) ||
+        (HasGLExtension("GL_ARB_texture_float") && HasGLExtension("GL_ARB_half_float_pixel"));
+}
+
+static const char* overrange_fragment_shader =
+    "#version 120\n"
+    "void main() { gl_FragColor = vec4(3.0, -1.0, 0.5, 1.0); }\n";
+
+// Renders values outside [0, 1] into a float target and reads them back. The
+// format only counts as renderable if they survive unclamped.
+static bool IsFloatRenderable(const FloatFormat& format, GLuint program) {
+    Framebuffer fb;
+    bool renderable = CreateFramebuffer(&fb, 4, 4, format.internal_format, GL_RGBA, format.type);
+    if (renderable) {
+        gl.UseProgram(program);
+        DrawFullscreenQuad();
+        gl.UseProgram(0);
+        GLfloat pixel[4] = { 0, 0, 0, 0 };
+        glReadPixels(1, 1, 1, 1, GL_RGBA, GL_FLOAT, pixel);
+        renderable = (pixel[0] == 3.f && pixel[1] == -1.f && pixel[2] == 0.5f);
+    }
+    DestroyFramebuffer(&fb);
+    return renderable;
+}
+
+// Samples halfway between a 0 and a 1 texel. Linear filtering gives 0.5,
+// drivers which can only point sample float textures give 0 or 1.
+static bool IsFloatFilterable(const FloatFormat& format, GLuint program) {
+    GLfloat texels[] = { 0.f, 0.f, 0.f, 1.f, 1.f, 1.f, 1.f, 1.f };
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, 2, 1, 0, GL_RGBA, GL_FLOAT, texels);
+
+    Framebuffer fb;
+    CreateFramebuffer(&fb, 1, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    gl.UseProgram(program);
+    gl.Uniform1i(gl.GetUniformLocation(program, "tex"), 0);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    DrawFullscreenQuad();
+    gl.UseProgram(0);
+    GLubyte pixel[4] = { 0, 0, 0, 0 };
+    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    DestroyFramebuffer(&fb);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &tex);
+    return (pixel[0] > 96 && pixel[0] < 160);
+}
+
+// HDR, GPGPU and simulation content needs float textures it can filter and
+// render to, and an extension being advertised often doesn't mean both work.
+// For half float and float we upload a texture, check it filters linearly,
+// and check values outside [0, 1] survive rendering into it.
+CheckResult CheckFloatTextures() {
+    std::string report;
+    sprintf(msg_buf, "GL_ARB_texture_float: %s\nGL_ARB_half_float_pixel: %s\nGL_ARB_color_buffer_float: %s\n",
+        HasGLExtension("GL_ARB_texture_float") ? "yes" : "no",
+        HasGLExtension("GL_ARB_half_float_pixel") ? "yes" : "no",
+        HasGLExtension("GL_ARB_color_buffer_float") ? "yes" : "no");
+    report += msg_buf;
+
+    if (!HasFloatTextures() || !HasFramebufferObjects()) {
+        ReportInfo("Warning", "Warning: Float textures aren't supported, OES_texture_float and EXT_color_buffer_float will be unavailable.\n" + report);
+        return WARNING;
+    }
+
+    GLuint render_program = CreateProgram(fullscreen_vertex_shader, overrange_fragment_shader, NULL);
+    GLuint sample_program = CreateProgram(fullscreen_vertex_shader, textured_fragment_shader, NULL);
+    CheckResult result = PASS;
+    for(int f = 0; f < num_float_formats; f++) {
+        const FloatFormat& format = float_formats[f];
+        bool filterable = sample_program != 0 && IsFloatFilterable(format, sample_program);
+        bool renderable = render_program != 0 && IsFloatRenderable(format, render_program);
+        sprintf(msg_buf, "%s: linear filtering %s, renderable %s\n", format.name,
+            filterable ? "yes" : "no", renderable ? "yes" : "no");
+        report += msg_buf;
+        if (!filterable || !renderable)
+            result = WARNING;
+    }
+    if (render_program != 0)
+        gl.DeleteProgram(render_program);
+    if (sample_program != 0)
+        gl.DeleteProgram(sample_program);
+
+    if (result == WARNING)
+        ReportInfo("Warning", "Warning: Float textures don't fully work, HDR and GPGPU content may fail or fall back.\n" + report);
+    else
+        ReportInfo("Float textures", report);
+    return result;
+}
+
+// Depth texture formats, the desktop equivalents of what WEBGL_depth_texture
+// exposes.
+typedef struct DepthFormatStruct
+{
+  const char* name;
+  GLenum internal_format;
+  GLenum format;
+  GLenum type;
+} DepthFormat;
+
+static const DepthFormat depth_formats[] = {
+    { "DEPTH_COMPONENT16", GL_DEPTH_COMPONENT16, GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT },
+    { "DEPTH_COMPONENT24", GL_DEPTH_COMPONENT24, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT },
+    { "DEPTH24_STENCIL8", GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 },
+};
+static const int num_depth_formats = sizeof(depth_formats) / sizeof(depth_formats[0]);
+
+bool HasDepthTextures() {
+    return HasGLVersion(1, 4) || HasGLExtension("GL_ARB_depth_texture");
+}
+
+// Packed depth stencil needs GL 3.0 or EXT_packed_depth_stencil.
+static bool HasDepthFormat(const DepthFormat& format) {
+    return format.format != GL_DEPTH_STENCIL ||
+        HasGLVersion(3, 0) || HasGLExtension("GL_EXT_packed_depth_stencil");
+}
+
+// Creates a framebuffer with just a depth texture attached (tex is the depth
+// texture), ready for a depth only pass, and leaves it bound. Returns false if
+// the driver can't render to the format.
+bool CreateDepthFramebuffer(Framebuffer* fb, int width, int height, const DepthFormat& format) {
+    fb->width = width;
+    fb->height = height;
+    glGenTextures(1, &fb->tex);
+    glBindTexture(GL_TEXTURE_2D, fb->tex);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, width, height, 0, format.format, format.type, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl.GenFramebuffers(1, &fb->fbo);
+    gl.BindFramebuffer(GL_FRAMEBUFFER, fb->fbo);
+    gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, fb->tex, 0);
+    if (format.format == GL_DEPTH_STENCIL)
+        gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, fb->tex, 0);
+    // Older drivers call a framebuffer without a color buffer incomplete
+    // unless it doesn't draw or read one.
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glViewport(0, 0, width, height);
+    return (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+}
+
+// Draws a full screen quad at the given depth.
+static void DrawQuadAtDepth(float z) {
+    glBegin(GL_TRIANGLE_STRIP);
+    glVertex3f(-1.f, -1.f, z);
+    glVertex3f(1.f, -1.f, z);
+    glVertex3f(-1.f, 1.f, z);
+    glVertex3f(1.f, 1.f, z);
+    glEnd();
+}
+
+static const char* shadow_compare_fragment_shader =
+    "#version 120\n"
+    "uniform sampler2DShadow shadow_map;\n"
+    "uniform float ref;\n"
+    "varying vec2 uv;\n"
+    "void main() { gl_FragColor = vec4(shadow2D(shadow_map, vec3(uv, ref)).rrr, 1.0); }\n";
+
+// Samples tex with the program over a small target and returns the red
+// channel.
+static int ReadSampledRed(GLuint program, GLuint tex) {
+    Framebuffer fb;
+    CreateFramebuffer(&fb, 4, 4, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    gl.UseProgram(program);
+    DrawFullscreenQuad();
+    gl.UseProgram(0);
+    GLubyte pixel[4] = { 0, 0, 0, 0 };
+    glReadPixels(1, 1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    DestroyFramebuffer(&fb);
+    return pixel[0];
+}
+
+// Shadow mapping needs depth textures which can be rendered to, sampled, and
+// compared against with GL_TEXTURE_COMPARE_MODE. For each format we write a
+// depth of 0.5 in a depth only pass, then sample it directly and with
+// comparisons either side of it.
+CheckResult CheckDepthTextures() {
+    std::string report;
+    sprintf(msg_buf, "GL_ARB_depth_texture: %s\nGL_ARB_shadow: %s\nGL_EXT_packed_depth_stencil: %s\n",
+        HasGLExtension("GL_ARB_depth_texture") ? "yes" : "no",
+        HasGLExtension("GL_ARB_shadow") ? "yes" : "no",
+        HasGLExtension("GL_EXT_packed_depth_stencil") ? "yes" : "no");
+    report += msg_buf;
+
+    if (!HasDepthTextures() || !HasFramebufferObjects()) {
+        ReportInfo("Warning", "Warning: Depth textures aren't supported, WEBGL_depth_texture and shadow mapping will be unavailable.\n" + report);
+        return WARNING;
+    }
+
+    GLuint sample_program = CreateProgram(fullscreen_vertex_shader, textured_fragment_shader, NULL);
+    GLuint compare_program = CreateProgram(fullscreen_vertex_shader, shadow_compare_fragment_shader, NULL);
+    CheckResult result = PASS;
+    for(int f = 0; f < num_depth_formats; f++) {
+        const DepthFormat& format = depth_formats[f];
+        if (!HasDepthFormat(format)) {
+            sprintf(msg_buf, "%s: unsupported\n", format.name);
+            report += msg_buf;
+            continue;
+        }
+
+        Framebuffer depth_fb;
+        bool renderable = CreateDepthFramebuffer(&depth_fb, 4, 4, format);
+        bool sampled = false, compared = false;
+        if (renderable) {
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_ALWAYS);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            DrawQuadAtDepth(0.f);
+            glDepthFunc(GL_LESS);
+            glDisable(GL_DEPTH_TEST);
+
+            if (sample_program != 0) {
+                int red = ReadSampledRed(sample_program, depth_fb.tex);
+                sampled = (red > 120 && red < 136);
+            }
+            if (compare_program != 0) {
+                glBindTexture(GL_TEXTURE_2D, depth_fb.tex);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                GLint ref_location = gl.GetUniformLocation(compare_program, "ref");
+                gl.UseProgram(compare_program);
+                gl.Uniform1f(ref_location, 0.4f);
+                int in_front = ReadSampledRed(compare_program, depth_fb.tex);
+                gl.UseProgram(compare_program);
+                gl.Uniform1f(ref_location, 0.6f);
+                int behind = ReadSampledRed(compare_program, depth_fb.tex);
+                compared = (in_front == 255 && behind == 0);
+            }
+        }
+        DestroyFramebuffer(&depth_fb);
+
+        sprintf(msg_buf, "%s: renderable %s, sampled %s, comparison %s\n", format.name,
+            renderable ? "yes" : "no", sampled ? "yes" : "no", compared ? "yes" : "no");
+        report += msg_buf;
+        if (!renderable || !sampled || !compared)
+            result = WARNING;
+    }
+    if (sample_program != 0)
+        gl.DeleteProgram(sample_program);
+    if (compare_program != 0)
+        gl.DeleteProgram(compare_program);
+
+    if (result == WARNING)
+        ReportInfo("Warning", "Warning: Depth textures don't fully work, WEBGL_depth_texture or shadow mapping may be unavailable.\n" + report);
+    else
+        ReportInfo("Depth textures", report);
+    return result;
+}
+
+// Always take a few samples, even if they're slow, so the median means
+// something.
+bool KeepBenchmarking(int iteration, double start) {
+    if (iteration < 3)
+        return true;
+    return (iteration < benchmark_iterations && GetTime() - start < benchmark_time_limit);
+}
+
+// Nearest rank percentiles, so every reported value is an actual sample.
+void ComputeTimingStats(std::vector<double> samples, TimingStats* stats) {
+    if (samples.empty()) {
+        stats->min = stats->median = stats->p95 = stats->p99 = stats->max = 0;
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    size_t last = samples.size() - 1;
+    stats->min = samples[0];
+    stats->median = samples[last / 2];
+    stats->p95 = samples[(size_t)(last * 0.95 + 0.5)];
+    stats->p99 = samples[(size_t)(last * 0.99 + 0.5)];
+    stats->max = samples[last];
+}
+
+// EXT_disjoint_timer_query doesn't count: it only provides the EXT suffixed
+// query entry points, which we don't load. Where it's advertised alongside
+// one of these we still honour its disjoint flag.
+bool HasTimerQueries() {
+    return HasGLVersion(3, 3) || HasGLExtension("GL_ARB_timer_query") ||
+        HasGLExtension("GL_EXT_timer_query");
+}
+
+void InitGPUTimer(GPUTimer* timer) {
+    timer->use_queries = HasTimerQueries();
+    timer->check_disjoint = HasGLExtension("GL_EXT_disjoint_timer_query");
+    timer->unfinished_passes = 0;
+    timer->current = 0;
+    timer->pending[0] = timer->pending[1] = false;
+    timer->cpu_samples.clear();
+    timer->gpu_samples.clear();
+    if (timer->use_queries)
+        gl.GenQueries(2, timer->queries);
+}
+
+static void CollectGPUTimerQuery(GPUTimer* timer, int index) {
+    if (!timer->pending[index])
+        return;
+    GLuint64 elapsed = 0;
+    gl.GetQueryObjectui64v(timer->queries[index], GL_QUERY_RESULT, &elapsed);
+    timer->pending[index] = false;
+    // With EXT_disjoint_timer_query the result is meaningless if something
+    // like a frequency change happened while it was running.
+    GLint disjoint = 0;
+    if (timer->check_disjoint)
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (!disjoint)
+        timer->gpu_samples.push_back(elapsed * 1e-9);
+}
+
+void BeginGPUTimer(GPUTimer* timer) {
+    if (timer->use_queries) {
+        CollectGPUTimerQuery(timer, timer->current);
+        gl.BeginQuery(GL_TIME_ELAPSED, timer->queries[timer->current]);
+    }
+    timer->pass_start = GetTime();
+    if (!timer->use_queries && timer->unfinished_passes == 0)
+        timer->run_start = timer->pass_start;
+}
+
+void EndGPUTimer(GPUTimer* timer) {
+    double submitted = GetTime();
+    timer->cpu_samples.push_back(submitted - timer->pass_start);
+    if (timer->use_queries) {
+        gl.EndQuery(GL_TIME_ELAPSED);
+        timer->pending[timer->current] = true;
+        timer->current = 1 - timer->current;
+    }
+    else {
+        timer->unfinished_passes++;
+    }
+}
+
+void FinishGPUTimer(GPUTimer* timer) {
+    if (!timer->use_queries) {
+        if (timer->unfinished_passes > 0) {
+            glFinish();
+            timer->gpu_samples.push_back((GetTime() - timer->run_start) / timer->unfinished_passes);
+            timer->unfinished_passes = 0;
+        }
+        return;
+    }
+    // Oldest first, so samples stay in pass order.
+    CollectGPUTimerQuery(timer, timer->current);
+    CollectGPUTimerQuery(timer, 1 - timer->current);
+}
+
+void DestroyGPUTimer(GPUTimer* timer) {
+    FinishGPUTimer(timer);
+    if (timer->use_queries)
+        gl.DeleteQueries(2, timer->queries);
+}
+
+std::string FormatGPUTimer(GPUTimer* timer) {
+    FinishGPUTimer(timer);
+    TimingStats cpu, gpu;
+    ComputeTimingStats(timer->cpu_samples, &cpu);
+    ComputeTimingStats(timer->gpu_samples, &gpu);
+    char buf[128];
+    sprintf(buf, "CPU %.3f ms, GPU %.3f ms", cpu.median * 1000.0, gpu.median * 1000.0);
+    return buf;
+}
+
+// Every WebGL page load creates a context, so creation latency adds directly
+// to page load time. Creates and destroys contexts in each configuration the
+// platform supports and reports latency percentiles and how much resident
+// memory grew, which catches drivers leaking per context.
+void BenchmarkContextCreation() {
+    struct Variant {
+        const char* name;
+        ContextSurface surface;
+        bool reuse_connection;
+    };
+    static const Variant variants[] = {
+        { "window, new connection", WINDOW_SURFACE, false },
+        { "window, reused connection", WINDOW_SURFACE, true },
+        { "pbuffer, new connection", PBUFFER_SURFACE, false },
+        { "pbuffer, reused connection", PBUFFER_SURFACE, true },
+        { "surfaceless, new connection", NO_SURFACE, false },
+        { "surfaceless, reused connection", NO_SURFACE, true },
+    };
+
+    std::string report;
+    sprintf(msg_buf, "Context create/destroy latency, %d iterations:\n", benchmark_iterations);
+    report += msg_buf;
+
+    for(size_t v = 0; v < sizeof(variants) / sizeof(variants[0]); v++) {
+        ContextOptions options;
+        InitContextOptions(&options);
+        options.surface = variants[v].surface;
+        if (variants[v].reuse_connection)
+            options.connection = &ctx;
+
+        std::vector<double> samples;
+        size_t rss_before = GetResidentMemory();
+        for(int i = 0; i < benchmark_iterations; i++) {
+            GLContext bench_ctx;
+            InitContext(&bench_ctx);
+            double start = GetTime();
+            GLboolean failed = CreateContextWithOptions(&bench_ctx, &options);
+            // Creation is often lazy, so make sure the context has done
+            // some work before we consider it ready.
+            if (!failed)
+                glFinish();
+            // Rebind ctx before tearing down, as a browser switching back
+            // to its own context would.
+            MakeContextCurrent(&ctx);
+            DestroyContext(&bench_ctx);
+            double elapsed = GetTime() - start;
+            if (failed)
+                break;
+            samples.push_back(elapsed * 1000.0);
+        }
+        size_t rss_after = GetResidentMemory();
+
+        if (samples.empty()) {
+            sprintf(msg_buf, "%s: unavailable\n", variants[v].name);
+        }
+        else {
+            TimingStats stats;
+            ComputeTimingStats(samples, &stats);
+            sprintf(msg_buf, "%s: min %.3f ms, median %.3f ms, p95 %.3f ms, p99 %.3f ms, RSS %+ld kB\n",
+                variants[v].name, stats.min, stats.median, stats.p95, stats.p99,
+                ((long)rss_after - (long)rss_before) / 1024);
+        }
+        report += msg_buf;
+    }
+
+    ReportInfo("Benchmark", report);
+}
+
+// Canvas sizes benchmarks render at.
+typedef struct CanvasSizeStruct
+{
+    const char* name;
+    int width, height;
+} CanvasSize;
+
+static const CanvasSize canvas_sizes[] = {
+    { "720p", 1280, 720 },
+    { "1080p", 1920, 1080 },
+    { "4K", 3840, 2160 },
+};
+static const int num_canvas_sizes = sizeof(canvas_sizes) / sizeof(canvas_sizes[0]);
+
+// Roughly what a lit, procedurally textured material costs.
+static const char* complex_fragment_shader =
+    "#version 120\n"
+    "varying vec2 uv;\n"
+    "void main() {\n"
+    "    vec3 n = normalize(vec3(sin(uv.x * 31.0), cos(uv.y * 17.0), 1.0));\n"
+    "    vec3 color = vec3(0.0);\n"
+    "    for (int i = 0; i < 4; i++) {\n"
+    "        vec3 l = normalize(vec3(cos(float(i)), sin(float(i)), 1.0));\n"
+    "        vec3 h = normalize(l + vec3(0.0, 0.0, 1.0));\n"
+    "        float diffuse = max(dot(n, l), 0.0);\n"
+    "        float specular = pow(max(dot(n, h), 0.0), 32.0);\n"
+    "        color += vec3(0.2, 0.3, 0.4) * diffuse + vec3(specular);\n"
+    "    }\n"
+    "    gl_FragColor = vec4(fract(color + uv.xyx), 1.0);\n"
+    "}\n";
+
+// Fill rate decides what canvas size a host can keep up with. Draws layers of
+// full screen quads into an FBO at common canvas sizes and reports Mpixels/s
+// over the whole run. The per pass GPU time is reported separately since some
+// software renderers' timer queries don't cover rasterization.
+void BenchmarkFillRate() {
+    const int layers = 4;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Fill rate: framebuffer objects not available.");
+        return;
+    }
+
+    GLuint programs[2];
+    static const char* program_names[] = { "trivial", "complex" };
+    programs[0] = CreateProgram(fullscreen_vertex_shader, trivial_fragment_shader, NULL);
+    programs[1] = CreateProgram(fullscreen_vertex_shader, complex_fragment_shader, NULL);
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+    std::string report = "Fill rate:\n";
+    for(int sz = 0; sz < num_canvas_sizes; sz++) {
+        const CanvasSize& size = canvas_sizes[sz];
+        Framebuffer fb;
+        if (size.width > max_size || !CreateFramebuffer(&fb, size.width, size.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+            if (size.width <= max_size)
+                DestroyFramebuffer(&fb);
+            sprintf(msg_buf, "%s: unsupported\n", size.name);
+            report += msg_buf;
+            continue;
+        }
+
+        for(int p = 0; p < 2; p++) {
+            if (programs[p] == 0) {
+                sprintf(msg_buf, "%s %s: shader failed to compile\n", size.name, program_names[p]);
+                report += msg_buf;
+                continue;
+            }
+            gl.UseProgram(programs[p]);
+            // Warm up, some drivers compile lazily on first draw.
+            DrawFullscreenQuad();
+            glFinish();
+
+            GPUTimer timer;
+            InitGPUTimer(&timer);
+            double bench_start = GetTime();
+            int passes;
+            for(passes = 0; KeepBenchmarking(passes, bench_start); passes++) {
+                BeginGPUTimer(&timer);
+                for(int l = 0; l < layers; l++)
+                    DrawFullscreenQuad();
+                EndGPUTimer(&timer);
+            }
+            FinishGPUTimer(&timer);
+            glFinish();
+            double elapsed = GetTime() - bench_start;
+            double mpixels = (double)passes * layers * size.width * size.height / 1e6;
+            sprintf(msg_buf, "%s %s: %.1f Mpixels/s (%.2f ms per full canvas), %s per %d layers\n", size.name, program_names[p],
+                mpixels / elapsed, elapsed * 1000.0 / (passes * layers), FormatGPUTimer(&timer).c_str(), layers);
+            report += msg_buf;
+            DestroyGPUTimer(&timer);
+        }
+        gl.UseProgram(0);
+        DestroyFramebuffer(&fb);
+    }
+
+    for(int p = 0; p < 2; p++) {
+        if (programs[p] != 0)
+            gl.DeleteProgram(programs[p]);
+    }
+    ReportInfo("Benchmark", report);
+}
+
+// WebGL validates and forwards every call, so content is usually limited by
+// per draw call overhead in the driver. Issues lots of tiny draws with no
+// state changes in between into a small target, so rasterization is
+// negligible, and reports how long submission takes on the CPU and how many
+// draws complete per second.
+void BenchmarkDrawCalls() {
+    const int draws_per_frame = 20000;
+    const int triangles = 256;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Draw calls: framebuffer objects not available.");
+        return;
+    }
+
+    GLuint program = CreateProgram(fullscreen_vertex_shader, trivial_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Draw calls: shader failed to compile.");
+        return;
+    }
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, 64, 64, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Draw calls: framebuffer incomplete.");
+        return;
+    }
+
+    // A row of tiny, separate triangles so consecutive draws don't just
+    // repeat the same vertices.
+    std::vector<GLfloat> vertices;
+    std::vector<GLushort> indices;
+    for(int t = 0; t < triangles; t++) {
+        float x = -1.f + 2.f * t / triangles;
+        GLfloat tri[] = { x, -1.f, x + 0.005f, -1.f, x, -0.995f };
+        vertices.insert(vertices.end(), tri, tri + 6);
+        for(int v = 0; v < 3; v++)
+            indices.push_back((GLushort)(t * 3 + v));
+    }
+
+    GLuint buffers[2];
+    gl.GenBuffers(2, buffers);
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl.BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+    gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), &indices[0], GL_STATIC_DRAW);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    gl.EnableVertexAttribArray(0);
+    gl.UseProgram(program);
+
+    std::string report = "Draw calls:\n";
+    for(int elements = 0; elements < 2; elements++) {
+        std::vector<double> total_samples;
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        glFinish();
+        double bench_start = GetTime();
+        for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+            BeginGPUTimer(&timer);
+            double start = GetTime();
+            for(int d = 0; d < draws_per_frame; d++) {
+                int t = d % triangles;
+                if (elements)
+                    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, (const void*)(t * 3 * sizeof(GLushort)));
+                else
+                    glDrawArrays(GL_TRIANGLES, t * 3, 3);
+            }
+            EndGPUTimer(&timer);
+            glFinish();
+            total_samples.push_back(GetTime() - start);
+        }
+        FinishGPUTimer(&timer);
+        TimingStats submit, total;
+        ComputeTimingStats(timer.cpu_samples, &submit);
+        ComputeTimingStats(total_samples, &total);
+        sprintf(msg_buf, "%s: %.0f draws/s, %.3f us CPU per draw, %s per frame\n",
+            elements ? "glDrawElements" : "glDrawArrays",
+            draws_per_frame / total.median, submit.median * 1e6 / draws_per_frame,
+            FormatGPUTimer(&timer).c_str());
+        report += msg_buf;
+        DestroyGPUTimer(&timer);
+    }
+
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DisableVertexAttribArray(0);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    gl.DeleteBuffers(2, buffers);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Streaming textures (video, image galleries, map tiles) is the heaviest
+// WebGL traffic. Uploads textures in several formats and sizes through
+// glTexImage2D, glTexSubImage2D and a pixel buffer object, and reports
+// bandwidth and how long until the texture can actually be sampled.
+void BenchmarkTextureUpload() {
+    struct UploadFormat {
+        const char* name;
+        GLenum internal_format, format, type;
+        int bytes_per_pixel;
+        bool is_float;
+    };
+    static const UploadFormat formats[] = {
+        { "RGBA8", GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false },
+        { "RGB8", GL_RGB8, GL_RGB, GL_UNSIGNED_BYTE, 3, false },
+        { "LUMINANCE8", GL_LUMINANCE8, GL_LUMINANCE, GL_UNSIGNED_BYTE, 1, false },
+        { "RGBA16F", GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, true },
+        { "RGBA32F", GL_RGBA32F, GL_RGBA, GL_FLOAT, 16, true },
+    };
+    static const int sizes[] = { 256, 1024, 2048 };
+    enum UploadPath { TEX_IMAGE, TEX_SUB_IMAGE, PIXEL_BUFFER };
+    static const char* path_names[] = { "glTexImage2D", "glTexSubImage2D", "PBO" };
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Texture upload: framebuffer objects not available.");
+        return;
+    }
+    GLuint program = CreateProgram(fullscreen_vertex_shader, textured_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Texture upload: shader failed to compile.");
+        return;
+    }
+    bool have_float = HasFloatTextures();
+    bool have_pbo = HasGLVersion(2, 1) || HasGLExtension("GL_ARB_pixel_buffer_object");
+
+    // Sampling a single texel into a 1x1 target and reading it back is the
+    // earliest point content could see the new data.
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, 1, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Texture upload: framebuffer incomplete.");
+        return;
+    }
+    gl.UseProgram(program);
+    gl.Uniform1i(gl.GetUniformLocation(program, "tex"), 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    GLuint pbo = 0;
+    if (have_pbo)
+        gl.GenBuffers(1, &pbo);
+
+    std::string report = "Texture upload:\n";
+    for(size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        const UploadFormat& format = formats[f];
+        if (format.is_float && !have_float) {
+            sprintf(msg_buf, "%s: unsupported\n", format.name);
+            report += msg_buf;
+            continue;
+        }
+        for(size_t sz = 0; sz < sizeof(sizes) / sizeof(sizes[0]); sz++) {
+            int size = sizes[sz];
+            size_t bytes = (size_t)size * size * format.bytes_per_pixel;
+            std::vector<unsigned char> data(bytes, 0x3c);
+
+            for(int path = TEX_IMAGE; path <= PIXEL_BUFFER; path++) {
+                if (path == PIXEL_BUFFER && !have_pbo)
+                    continue;
+
+                GLuint tex;
+                glGenTextures(1, &tex);
+                glBindTexture(GL_TEXTURE_2D, tex);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, size, size, 0, format.format, format.type, NULL);
+                glFinish();
+
+                std::vector<double> upload_samples, sample_samples;
+                GPUTimer timer;
+                InitGPUTimer(&timer);
+                double bench_start = GetTime();
+                for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+                    BeginGPUTimer(&timer);
+                    double start = GetTime();
+                    if (path == TEX_IMAGE) {
+                        glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, size, size, 0, format.format, format.type, &data[0]);
+                    }
+                    else if (path == TEX_SUB_IMAGE) {
+                        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, format.format, format.type, &data[0]);
+                    }
+                    else {
+                        // Orphan the buffer so we never wait on the previous
+                        // upload, then copy in and upload from it.
+                        gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+                        gl.BufferData(GL_PIXEL_UNPACK_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+                        void* mapped = gl.MapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+                        if (mapped != NULL) {
+                            memcpy(mapped, &data[0], bytes);
+                            gl.UnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                        }
+                        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, format.format, format.type, 0);
+                        gl.BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+                    }
+                    EndGPUTimer(&timer);
+                    glFinish();
+                    double uploaded = GetTime();
+
+                    unsigned char pixel[4];
+                    DrawFullscreenQuad();
+                    glReadPixels(0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+                    double sampled = GetTime();
+
+                    upload_samples.push_back(uploaded - start);
+                    sample_samples.push_back(sampled - start);
+                }
+
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glDeleteTextures(1, &tex);
+
+                TimingStats upload, first_sample;
+                ComputeTimingStats(upload_samples, &upload);
+                ComputeTimingStats(sample_samples, &first_sample);
+                sprintf(msg_buf, "%s %dx%d %s: %.2f GB/s, first sample after %.3f ms, %s per upload\n",
+                    format.name, size, size, path_names[path],
+                    bytes / upload.median / 1e9, first_sample.median * 1000.0,
+                    FormatGPUTimer(&timer).c_str());
+                report += msg_buf;
+                DestroyGPUTimer(&timer);
+            }
+        }
+    }
+
+    if (pbo != 0)
+        gl.DeleteBuffers(1, &pbo);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Headless rendering reads every frame back, in RGBA/UNSIGNED_BYTE as WebGL
+// requires. Compares a blocking glReadPixels each frame against reading into
+// a ring of pixel pack buffers and only mapping each one once its fence has
+// signalled a couple of frames later.
+void BenchmarkReadback() {
+    const int ring_size = 3;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Readback: framebuffer objects not available.");
+        return;
+    }
+    GLuint program = CreateProgram(fullscreen_vertex_shader, complex_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Readback: shader failed to compile.");
+        return;
+    }
+    bool have_async = (HasGLVersion(2, 1) || HasGLExtension("GL_ARB_pixel_buffer_object")) &&
+        (HasGLVersion(3, 2) || HasGLExtension("GL_ARB_sync"));
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+
+    std::string report = "Readback:\n";
+    for(int sz = 0; sz < num_canvas_sizes; sz++) {
+        const CanvasSize& size = canvas_sizes[sz];
+        size_t bytes = (size_t)size.width * size.height * 4;
+        Framebuffer fb;
+        if (size.width > max_size || !CreateFramebuffer(&fb, size.width, size.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+            if (size.width <= max_size)
+                DestroyFramebuffer(&fb);
+            sprintf(msg_buf, "%s: unsupported\n", size.name);
+            report += msg_buf;
+            continue;
+        }
+        gl.UseProgram(program);
+        std::vector<unsigned char> pixels(bytes);
+
+        // Synchronous: the readback waits for the frame to finish rendering.
+        std::vector<double> frame_samples, read_samples;
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        glFinish();
+        double bench_start = GetTime();
+        for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+            BeginGPUTimer(&timer);
+            double start = GetTime();
+            DrawFullscreenQuad();
+            double issued = GetTime();
+            glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, &pixels[0]);
+            double done = GetTime();
+            EndGPUTimer(&timer);
+            frame_samples.push_back(done - start);
+            read_samples.push_back(done - issued);
+        }
+        TimingStats frame, read;
+        ComputeTimingStats(frame_samples, &frame);
+        ComputeTimingStats(read_samples, &read);
+        sprintf(msg_buf, "%s glReadPixels: %.3f ms blocked per frame, %.1f frames/s, %.2f GB/s, %s per frame\n",
+            size.name, read.median * 1000.0, 1.0 / frame.median, bytes / frame.median / 1e9,
+            FormatGPUTimer(&timer).c_str());
+        report += msg_buf;
+        DestroyGPUTimer(&timer);
+
+        if (have_async) {
+            GLuint pbos[ring_size];
+            GLsync fences[ring_size];
+            double issue_times[ring_size];
+            gl.GenBuffers(ring_size, pbos);
+            for(int r = 0; r < ring_size; r++) {
+                gl.BindBuffer(GL_PIXEL_PACK_BUFFER, pbos[r]);
+                gl.BufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+                fences[r] = NULL;
+            }
+
+            std::vector<double> cpu_samples, latency_samples;
+            InitGPUTimer(&timer);
+            glFinish();
+            bench_start = GetTime();
+            // Keep issuing frames until we have enough samples, reading each
+            // one back once the ring is full, then drain what's in flight.
+            int issued = 0, frames = 0;
+            while (true) {
+                bool issue = KeepBenchmarking(issued, bench_start);
+                if (!issue && frames == issued)
+                    break;
+                double start = 0;
+                if (issue) {
+                    int slot = issued % ring_size;
+                    BeginGPUTimer(&timer);
+                    start = GetTime();
+                    DrawFullscreenQuad();
+                    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+                    glReadPixels(0, 0, size.width, size.height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+                    EndGPUTimer(&timer);
+                    fences[slot] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                    issue_times[slot] = GetTime();
+                    issued++;
+                }
+                if (issued - frames >= ring_size || !issue) {
+                    int slot = frames % ring_size;
+                    gl.ClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, (GLuint64)1000000000);
+                    gl.DeleteSync(fences[slot]);
+                    fences[slot] = NULL;
+                    gl.BindBuffer(GL_PIXEL_PACK_BUFFER, pbos[slot]);
+                    void* mapped = gl.MapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+                    if (mapped != NULL) {
+                        memcpy(&pixels[0], mapped, bytes);
+                        gl.UnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                    }
+                    latency_samples.push_back(GetTime() - issue_times[slot]);
+                    frames++;
+                }
+                if (issue)
+                    cpu_samples.push_back(GetTime() - start);
+            }
+            double elapsed = GetTime() - bench_start;
+            gl.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            gl.DeleteBuffers(ring_size, pbos);
+
+            TimingStats cpu, latency;
+            ComputeTimingStats(cpu_samples, &cpu);
+            ComputeTimingStats(latency_samples, &latency);
+            sprintf(msg_buf, "%s PBO + fence: %.3f ms CPU per frame, %.3f ms latency, %.1f frames/s, %.2f GB/s, %s per issue\n",
+                size.name, cpu.median * 1000.0, latency.median * 1000.0,
+                frames / elapsed, frames * (double)bytes / elapsed / 1e9,
+                FormatGPUTimer(&timer).c_str());
+            report += msg_buf;
+            DestroyGPUTimer(&timer);
+        }
+        else {
+            sprintf(msg_buf, "%s PBO + fence: unsupported\n", size.name);
+            report += msg_buf;
+        }
+
+        gl.UseProgram(0);
+        DestroyFramebuffer(&fb);
+    }
+
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Browsers implement bufferSubData on top of one of these, and which one is
+// fastest depends on the driver. Each frame uploads a chunk of vertices with
+// the given strategy and draws from it, so the driver has to deal with the
+// buffer still being in use. An upload which takes more than four times the
+// median is counted as a stall.
+void BenchmarkVertexStreaming() {
+    const int chunk_vertices = 65536;
+    const int ring_segments = 4;
+    const GLsizeiptr chunk_bytes = chunk_vertices * 2 * sizeof(GLfloat);
+
+    enum StreamStrategy { BUFFER_DATA, ORPHAN, SUB_DATA_RING, MAP_UNSYNCHRONIZED, MAP_PERSISTENT, NUM_STRATEGIES };
+    static const char* strategy_names[] = {
+        "glBufferData", "orphan + glBufferSubData", "glBufferSubData ring",
+        "glMapBufferRange unsynchronized", "persistent mapping"
+    };
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Vertex streaming: framebuffer objects not available.");
+        return;
+    }
+    GLuint program = CreateProgram(fullscreen_vertex_shader, trivial_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Vertex streaming: shader failed to compile.");
+        return;
+    }
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, 64, 64, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Vertex streaming: framebuffer incomplete.");
+        return;
+    }
+    bool have_sync = HasGLVersion(3, 2) || HasGLExtension("GL_ARB_sync");
+    bool supported[NUM_STRATEGIES] = { true, true, true,
+        have_sync && (HasGLVersion(3, 0) || HasGLExtension("GL_ARB_map_buffer_range")),
+        have_sync && (HasGLVersion(4, 4) || HasGLExtension("GL_ARB_buffer_storage"))
+    };
+
+    std::vector<GLfloat> vertices(chunk_vertices * 2);
+    for(int v = 0; v < chunk_vertices; v++) {
+        vertices[v*2] = -1.f + 2.f * (v % 256) / 256.f;
+        vertices[v*2+1] = -1.f + 2.f * (v / 256) / 256.f;
+    }
+
+    gl.UseProgram(program);
+    gl.EnableVertexAttribArray(0);
+
+    std::string report = "Vertex streaming:\n";
+    for(int strategy = 0; strategy < NUM_STRATEGIES; strategy++) {
+        if (!supported[strategy]) {
+            sprintf(msg_buf, "%s: unsupported\n", strategy_names[strategy]);
+            report += msg_buf;
+            continue;
+        }
+
+        GLuint vbo;
+        gl.GenBuffers(1, &vbo);
+        gl.BindBuffer(GL_ARRAY_BUFFER, vbo);
+        GLsizeiptr ring_bytes = chunk_bytes * ring_segments;
+        void* persistent = NULL;
+        if (strategy == MAP_PERSISTENT) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            gl.BufferStorage(GL_ARRAY_BUFFER, ring_bytes, NULL, flags);
+            persistent = gl.MapBufferRange(GL_ARRAY_BUFFER, 0, ring_bytes, flags);
+            if (persistent == NULL) {
+                gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+                gl.DeleteBuffers(1, &vbo);
+                sprintf(msg_buf, "%s: mapping failed, unavailable\n", strategy_names[strategy]);
+                report += msg_buf;
+                continue;
+            }
+        }
+        else {
+            gl.BufferData(GL_ARRAY_BUFFER, (strategy == BUFFER_DATA || strategy == ORPHAN) ? chunk_bytes : ring_bytes,
+                NULL, GL_STREAM_DRAW);
+        }
+        GLsync fences[ring_segments];
+        for(int f = 0; f < ring_segments; f++)
+            fences[f] = NULL;
+
+        std::vector<double> upload_samples;
+        bool map_failed = false;
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        glFinish();
+        double bench_start = GetTime();
+        int frame;
+        for(frame = 0; KeepBenchmarking(frame, bench_start); frame++) {
+            int segment = frame % ring_segments;
+            GLintptr offset = 0;
+            BeginGPUTimer(&timer);
+            double start = GetTime();
+            if (strategy == BUFFER_DATA) {
+                gl.BufferData(GL_ARRAY_BUFFER, chunk_bytes, &vertices[0], GL_STREAM_DRAW);
+            }
+            else if (strategy == ORPHAN) {
+                gl.BufferData(GL_ARRAY_BUFFER, chunk_bytes, NULL, GL_STREAM_DRAW);
+                gl.BufferSubData(GL_ARRAY_BUFFER, 0, chunk_bytes, &vertices[0]);
+            }
+            else if (strategy == SUB_DATA_RING) {
+                offset = segment * chunk_bytes;
+                gl.BufferSubData(GL_ARRAY_BUFFER, offset, chunk_bytes, &vertices[0]);
+            }
+            else {
+                // Without synchronization from the driver we have to make
+                // sure the GPU is done with the segment ourselves.
+                offset = segment * chunk_bytes;
+                if (fences[segment] != NULL) {
+                    gl.ClientWaitSync(fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, (GLuint64)1000000000);
+                    gl.DeleteSync(fences[segment]);
+                    fences[segment] = NULL;
+                }
+                if (strategy == MAP_UNSYNCHRONIZED) {
+                    void* mapped = gl.MapBufferRange(GL_ARRAY_BUFFER, offset, chunk_bytes,
+                        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+                    if (mapped == NULL) {
+                        EndGPUTimer(&timer);
+                        map_failed = true;
+                        break;
+                    }
+                    memcpy(mapped, &vertices[0], chunk_bytes);
+                    gl.UnmapBuffer(GL_ARRAY_BUFFER);
+                }
+                else {
+                    memcpy((char*)persistent + offset, &vertices[0], chunk_bytes);
+                }
+            }
+            upload_samples.push_back(GetTime() - start);
+
+            gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (const void*)offset);
+            glDrawArrays(GL_POINTS, 0, chunk_vertices);
+            EndGPUTimer(&timer);
+            if (strategy == MAP_UNSYNCHRONIZED || strategy == MAP_PERSISTENT)
+                fences[segment] = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+        glFinish();
+        double elapsed = GetTime() - bench_start;
+
+        for(int f = 0; f < ring_segments; f++) {
+            if (fences[f] != NULL)
+                gl.DeleteSync(fences[f]);
+        }
+        if (persistent != NULL)
+            gl.UnmapBuffer(GL_ARRAY_BUFFER);
+        gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        gl.DeleteBuffers(1, &vbo);
+
+        if (map_failed) {
+            sprintf(msg_buf, "%s: mapping failed, unavailable\n", strategy_names[strategy]);
+            report += msg_buf;
+            DestroyGPUTimer(&timer);
+            continue;
+        }
+        TimingStats upload;
+        ComputeTimingStats(upload_samples, &upload);
+        int stalls = 0;
+        for(size_t i = 0; i < upload_samples.size(); i++) {
+            if (upload_samples[i] > upload.median * 4)
+                stalls++;
+        }
+        sprintf(msg_buf, "%s: %.1f MB/s upload, %.1f MB/s sustained with draws, upload median %.3f ms, p99 %.3f ms, %d stalls in %d frames, %s per frame\n",
+            strategy_names[strategy], chunk_bytes / upload.median / (1024 * 1024),
+            (double)frame * chunk_bytes / elapsed / (1024 * 1024),
+            upload.median * 1000.0, upload.p99 * 1000.0, stalls, frame,
+            FormatGPUTimer(&timer).c_str());
+        report += msg_buf;
+        DestroyGPUTimer(&timer);
+    }
+
+    gl.DisableVertexAttribArray(0);
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// A small corpus of programs in the style of typical WebGL content, from UI
+// quads up to a PBR material, for the compile benchmark. All of them take
+// their position from attribute 0 so they can be drawn with
+// DrawFullscreenQuad.
+typedef struct ShaderCorpusEntryStruct
+{
+    const char* name;
+    const char* vertex;
+    const char* fragment;
+} ShaderCorpusEntry;
+
+static const ShaderCorpusEntry shader_corpus[] = {
+    { "UI solid color",
+      "attribute vec4 position;\n"
+      "uniform mat4 transform;\n"
+      "void main() { gl_Position = transform * position; }\n",
+      "uniform vec4 color;\n"
+      "void main() { gl_FragColor = color; }\n" },
+
+    { "textured sprite",
+      "attribute vec4 position;\n"
+      "attribute vec2 texcoord;\n"
+      "uniform mat4 transform;\n"
+      "varying vec2 uv;\n"
+      "void main() { uv = texcoord; gl_Position = transform * position; }\n",
+      "uniform sampler2D image;\n"
+      "uniform vec4 tint;\n"
+      "varying vec2 uv;\n"
+      "void main() { gl_FragColor = texture2D(image, uv) * tint; }\n" },
+
+    { "9 tap blur",
+      "attribute vec4 position;\n"
+      "varying vec2 uv;\n"
+      "void main() { uv = position.xy * 0.5 + 0.5; gl_Position = position; }\n",
+      "uniform sampler2D image;\n"
+      "uniform vec2 direction;\n"
+      "varying vec2 uv;\n"
+      "void main() {\n"
+      "    vec4 sum = texture2D(image, uv) * 0.2270270270;\n"
+      "    sum += texture2D(image, uv + direction * 1.3846153846) * 0.3162162162;\n"
+      "    sum += texture2D(image, uv - direction * 1.3846153846) * 0.3162162162;\n"
+      "    sum += texture2D(image, uv + direction * 3.2307692308) * 0.0702702703;\n"
+      "    sum += texture2D(image, uv - direction * 3.2307692308) * 0.0702702703;\n"
+      "    sum += texture2D(image, uv + direction * 5.0769230769) * 0.0091891892;\n"
+      "    sum += texture2D(image, uv - direction * 5.0769230769) * 0.0091891892;\n"
+      "    sum += texture2D(image, uv + direction * 6.9230769231) * 0.0010810811;\n"
+      "    sum += texture2D(image, uv - direction * 6.9230769231) * 0.0010810811;\n"
+      "    gl_FragColor = sum;\n"
+      "}\n" },
+
+    { "Phong, 4 lights",
+      "attribute vec4 position;\n"
+      "attribute vec3 normal;\n"
+      "uniform mat4 model_view;\n"
+      "uniform mat4 projection;\n"
+      "uniform mat3 normal_matrix;\n"
+      "varying vec3 view_normal;\n"
+      "varying vec3 view_position;\n"
+      "void main() {\n"
+      "    vec4 p = model_view * position;\n"
+      "    view_position = p.xyz;\n"
+      "    view_normal = normal_matrix * normal;\n"
+      "    gl_Position = projection * p;\n"
+      "}\n",
+      "uniform vec3 light_positions[4];\n"
+      "uniform vec3 light_colors[4];\n"
+      "uniform vec3 diffuse_color;\n"
+      "uniform vec3 specular_color;\n"
+      "uniform float shininess;\n"
+      "varying vec3 view_normal;\n"
+      "varying vec3 view_position;\n"
+      "void main() {\n"
+      "    vec3 n = normalize(view_normal);\n"
+      "    vec3 v = normalize(-view_position);\n"
+      "    vec3 color = vec3(0.05) * diffuse_color;\n"
+      "    for (int i = 0; i < 4; i++) {\n"
+      "        vec3 l = light_positions[i] - view_position;\n"
+      "        float attenuation = 1.0 / (1.0 + dot(l, l));\n"
+      "        l = normalize(l);\n"
+      "        vec3 r = reflect(-l, n);\n"
+      "        color += light_colors[i] * attenuation * (diffuse_color * max(dot(n, l), 0.0) +\n"
+      "            specular_color * pow(max(dot(r, v), 0.0), shininess));\n"
+      "    }\n"
+      "    gl_FragColor = vec4(color, 1.0);\n"
+      "}\n" },
+
+    { "skinned, 32 bones",
+      "attribute vec4 position;\n"
+      "attribute vec3 normal;\n"
+      "attribute vec4 bone_weights;\n"
+      "attribute vec4 bone_indices;\n"
+      "uniform mat4 bones[32];\n"
+      "uniform mat4 model_view_projection;\n"
+      "varying vec3 world_normal;\n"
+      "void main() {\n"
+      "    mat4 skin = bones[int(bone_indices.x)] * bone_weights.x +\n"
+      "        bones[int(bone_indices.y)] * bone_weights.y +\n"
+      "        bones[int(bone_indices.z)] * bone_weights.z +\n"
+      "        bones[int(bone_indices.w)] * bone_weights.w;\n"
+      "    world_normal = (skin * vec4(normal, 0.0)).xyz;\n"
+      "    gl_Position = model_view_projection * skin * position;\n"
+      "}\n",
+      "uniform vec3 light_direction;\n"
+      "varying vec3 world_normal;\n"
+      "void main() {\n"
+      "    float d = max(dot(normalize(world_normal), light_direction), 0.0);\n"
+      "    gl_FragColor = vec4(vec3(0.1 + 0.9 * d), 1.0);\n"
+      "}\n" },
+
+    { "PBR, 8 lights",
+      "attribute vec4 position;\n"
+      "attribute vec3 normal;\n"
+      "attribute vec4 tangent;\n"
+      "attribute vec2 texcoord;\n"
+      "uniform mat4 model;\n"
+      "uniform mat4 view_projection;\n"
+      "uniform mat3 normal_matrix;\n"
+      "varying vec3 world_position;\n"
+      "varying vec3 world_normal;\n"
+      "varying vec3 world_tangent;\n"
+      "varying vec3 world_bitangent;\n"
+      "varying vec2 uv;\n"
+      "void main() {\n"
+      "    vec4 p = model * position;\n"
+      "    world_position = p.xyz;\n"
+      "    world_normal = normalize(normal_matrix * normal);\n"
+      "    world_tangent = normalize(normal_matrix * tangent.xyz);\n"
+      "    world_bitangent = cross(world_normal, world_tangent) * tangent.w;\n"
+      "    uv = texcoord;\n"
+      "    gl_Position = view_projection * p;\n"
+      "}\n",
+      "uniform sampler2D base_color_map;\n"
+      "uniform sampler2D normal_map;\n"
+      "uniform sampler2D metallic_roughness_map;\n"
+      "uniform sampler2D occlusion_map;\n"
+      "uniform sampler2D emissive_map;\n"
+      "uniform samplerCube environment_map;\n"
+      "uniform vec3 camera_position;\n"
+      "uniform vec3 light_positions[8];\n"
+      "uniform vec3 light_colors[8];\n"
+      "uniform float exposure;\n"
+      "varying vec3 world_position;\n"
+      "varying vec3 world_normal;\n"
+      "varying vec3 world_tangent;\n"
+      "varying vec3 world_bitangent;\n"
+      "varying vec2 uv;\n"
+      "const float PI = 3.14159265359;\n"
+      "float DistributionGGX(vec3 n, vec3 h, float roughness) {\n"
+      "    float a = roughness * roughness;\n"
+      "    float a2 = a * a;\n"
+      "    float n_dot_h = max(dot(n, h), 0.0);\n"
+      "    float denom = n_dot_h * n_dot_h * (a2 - 1.0) + 1.0;\n"
+      "    return a2 / (PI * denom * denom);\n"
+      "}\n"
+      "float GeometrySchlickGGX(float n_dot_v, float roughness) {\n"
+      "    float k = (roughness + 1.0) * (roughness + 1.0) / 8.0;\n"
+      "    return n_dot_v / (n_dot_v * (1.0 - k) + k);\n"
+      "}\n"
+      "float GeometrySmith(vec3 n, vec3 v, vec3 l, float roughness) {\n"
+      "    return GeometrySchlickGGX(max(dot(n, v), 0.0), roughness) *\n"
+      "        GeometrySchlickGGX(max(dot(n, l), 0.0), roughness);\n"
+      "}\n"
+      "vec3 FresnelSchlick(float cos_theta, vec3 f0) {\n"
+      "    return f0 + (1.0 - f0) * pow(1.0 - cos_theta, 5.0);\n"
+      "}\n"
+      "vec3 ToneMapACES(vec3 x) {\n"
+      "    return clamp((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14), 0.0, 1.0);\n"
+      "}\n"
+      "void main() {\n"
+      "    vec3 albedo = pow(texture2D(base_color_map, uv).rgb, vec3(2.2));\n"
+      "    vec2 mr = texture2D(metallic_roughness_map, uv).bg;\n"
+      "    float metallic = mr.x;\n"
+      "    float roughness = max(mr.y, 0.04);\n"
+      "    float ao = texture2D(occlusion_map, uv).r;\n"
+      "    vec3 tangent_normal = texture2D(normal_map, uv).xyz * 2.0 - 1.0;\n"
+      "    mat3 tbn = mat3(normalize(world_tangent), normalize(world_bitangent), normalize(world_normal));\n"
+      "    vec3 n = normalize(tbn * tangent_normal);\n"
+      "    vec3 v = normalize(camera_position - world_position);\n"
+      "    vec3 f0 = mix(vec3(0.04), albedo, metallic);\n"
+      "    vec3 lo = vec3(0.0);\n"
+      "    for (int i = 0; i < 8; i++) {\n"
+      "        vec3 l = normalize(light_positions[i] - world_position);\n"
+      "        vec3 h = normalize(v + l);\n"
+      "        float distance = length(light_positions[i] - world_position);\n"
+      "        vec3 radiance = light_colors[i] / (distance * distance);\n"
+      "        float ndf = DistributionGGX(n, h, roughness);\n"
+      "        float g = GeometrySmith(n, v, l, roughness);\n"
+      "        vec3 f = FresnelSchlick(max(dot(h, v), 0.0), f0);\n"
+      "        vec3 specular = ndf * g * f / (4.0 * max(dot(n, v), 0.0) * max(dot(n, l), 0.0) + 0.0001);\n"
+      "        vec3 kd = (vec3(1.0) - f) * (1.0 - metallic);\n"
+      "        lo += (kd * albedo / PI + specular) * radiance * max(dot(n, l), 0.0);\n"
+      "    }\n"
+      "    vec3 r = reflect(-v, n);\n"
+      "    vec3 f = FresnelSchlick(max(dot(n, v), 0.0), f0);\n"
+      "    vec3 ambient = textureCube(environment_map, r).rgb * f * ao;\n"
+      "    vec3 color = ambient + lo + texture2D(emissive_map, uv).rgb;\n"
+      "    color = ToneMapACES(color * exposure);\n"
+      "    gl_FragColor = vec4(pow(color, vec3(1.0 / 2.2)), 1.0);\n"
+      "}\n" },
+};
+
+// Shader compilation is the biggest source of first frame jank. Compiles and
+// links each program in the corpus repeatedly and reports the latency
+// distribution of each step, plus the first draw since some drivers finish
+// compiling lazily. Every iteration gets a #define which is unique across runs
+// so the driver's shader cache (which may be on disk) can't hand back an
+// earlier result.
+void BenchmarkShaderCompile() {
+    Framebuffer fb;
+    bool have_fbo = HasFramebufferObjects();
+    if (have_fbo && !CreateFramebuffer(&fb, 1, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        have_fbo = false;
+    }
+
+    std::string report = "Shader compile (median / p95 / p99):\n";
+    for(size_t p = 0; p < sizeof(shader_corpus) / sizeof(shader_corpus[0]); p++) {
+        const ShaderCorpusEntry& entry = shader_corpus[p];
+        std::vector<double> vertex_samples, fragment_samples, link_samples, draw_samples;
+        bool failed = false;
+        // Compiling and linking is CPU work, but the first draw also
+        // splits into submission (where lazy compiles land) and execution.
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+
+        double bench_start = GetTime();
+        for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+            sprintf(msg_buf, "#version 120\n#define WIW_NONCE %.0f\n", GetTime() * 1e9);
+            std::string vertex_source = std::string(msg_buf) + entry.vertex;
+            std::string fragment_source = std::string(msg_buf) + entry.fragment;
+
+            // Querying the status forces any deferred compile or link work.
+            double start = GetTime();
+            GLuint vs = CompileShader(GL_VERTEX_SHADER, vertex_source.c_str(), NULL);
+            double vertex_done = GetTime();
+            GLuint fs = CompileShader(GL_FRAGMENT_SHADER, fragment_source.c_str(), NULL);
+            double fragment_done = GetTime();
+            if (vs == 0 || fs == 0) {
+                if (vs != 0) gl.DeleteShader(vs);
+                if (fs != 0) gl.DeleteShader(fs);
+                failed = true;
+                break;
+            }
+
+            GLuint program = gl.CreateProgram();
+            gl.AttachShader(program, vs);
+            gl.AttachShader(program, fs);
+            gl.BindAttribLocation(program, 0, "position");
+            gl.LinkProgram(program);
+            GLint linked = GL_FALSE;
+            gl.GetProgramiv(program, GL_LINK_STATUS, &linked);
+            double link_done = GetTime();
+            gl.DeleteShader(vs);
+            gl.DeleteShader(fs);
+            if (linked != GL_TRUE) {
+                gl.DeleteProgram(program);
+                failed = true;
+                break;
+            }
+
+            if (have_fbo) {
+                gl.UseProgram(program);
+                // Samplers of different types can't share a texture unit,
+                // so give each its own or the draw would be rejected.
+                GLint uniforms = 0, unit = 0;
+                gl.GetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniforms);
+                for(GLint u = 0; u < uniforms; u++) {
+                    GLchar name[256];
+                    GLint size;
+                    GLenum type;
+                    gl.GetActiveUniform(program, u, sizeof(name), NULL, &size, &type, name);
+                    if (type == GL_SAMPLER_2D || type == GL_SAMPLER_CUBE)
+                        gl.Uniform1i(gl.GetUniformLocation(program, name), unit++);
+                }
+                BeginGPUTimer(&timer);
+                DrawFullscreenQuad();
+                EndGPUTimer(&timer);
+                glFinish();
+                // Take each draw's GPU time now, so without timer queries
+                // the compiles in between aren't averaged into it.
+                FinishGPUTimer(&timer);
+                gl.UseProgram(0);
+                draw_samples.push_back(GetTime() - link_done);
+            }
+            gl.DeleteProgram(program);
+
+            vertex_samples.push_back(vertex_done - start);
+            fragment_samples.push_back(fragment_done - vertex_done);
+            link_samples.push_back(link_done - fragment_done);
+        }
+
+        std::string draw_times = FormatGPUTimer(&timer);
+        DestroyGPUTimer(&timer);
+        if (failed) {
+            sprintf(msg_buf, "%s: failed to compile\n", entry.name);
+            report += msg_buf;
+            continue;
+        }
+        TimingStats vertex, fragment, link, draw;
+        ComputeTimingStats(vertex_samples, &vertex);
+        ComputeTimingStats(fragment_samples, &fragment);
+        ComputeTimingStats(link_samples, &link);
+        ComputeTimingStats(draw_samples, &draw);
+        sprintf(msg_buf, "%s: vertex %.2f / %.2f / %.2f ms, fragment %.2f / %.2f / %.2f ms, "
+            "link %.2f / %.2f / %.2f ms, first draw %.2f / %.2f / %.2f ms (%s)\n",
+            entry.name,
+            vertex.median * 1000.0, vertex.p95 * 1000.0, vertex.p99 * 1000.0,
+            fragment.median * 1000.0, fragment.p95 * 1000.0, fragment.p99 * 1000.0,
+            link.median * 1000.0, link.p95 * 1000.0, link.p99 * 1000.0,
+            draw.median * 1000.0, draw.p95 * 1000.0, draw.p99 * 1000.0, draw_times.c_str());
+        report += msg_buf;
+    }
+
+    if (have_fbo)
+        DestroyFramebuffer(&fb);
+    ReportInfo("Benchmark", report);
+}
+
+// Clearing is pure memory bandwidth, so timing glClear at increasing sizes
+// shows where the host runs out of it and large canvases stop scaling. Clears
+// color, depth and stencil separately and together at square sizes doubling
+// up to GL_MAX_RENDERBUFFER_SIZE (or until allocation fails), and reports the
+// largest size that still clears at half the best color bandwidth.
+void BenchmarkClear() {
+    static const GLbitfield masks[] = {
+        GL_COLOR_BUFFER_BIT,
+        GL_DEPTH_BUFFER_BIT,
+        GL_STENCIL_BUFFER_BIT,
+        GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT,
+    };
+    static const char* mask_names[] = { "color", "depth", "stencil", "all" };
+    // RGBA8 color and packed 24/8 depth stencil, per pixel.
+    static const double mask_bytes[] = { 4, 4, 4, 8 };
+    const int num_masks = sizeof(masks) / sizeof(masks[0]);
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Clear: framebuffer objects not available.");
+        return;
+    }
+
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &max_size);
+
+    std::string report = "Clear:\n";
+    double best_bandwidth = 0;
+    int last_good_size = 0;
+    // Doubling, finishing on the maximum itself when it isn't a power of two.
+    for(int size = 256; size <= max_size; size = std::min(size * 2, (int)max_size)) {
+        // Drop any stale error so only the allocation's shows up.
+        while (glGetError() != GL_NO_ERROR)
+            ;
+        GLuint fbo, renderbuffers[2];
+        gl.GenFramebuffers(1, &fbo);
+        gl.GenRenderbuffers(2, renderbuffers);
+        gl.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+        gl.BindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+        gl.RenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+        gl.BindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+        gl.RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size, size);
+        gl.BindRenderbuffer(GL_RENDERBUFFER, 0);
+        gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, renderbuffers[0]);
+        gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, renderbuffers[1]);
+        bool out_of_memory = (glGetError() == GL_OUT_OF_MEMORY);
+        bool complete = (gl.CheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+        if (out_of_memory || !complete) {
+            sprintf(msg_buf, "%dx%d: %s\n", size, size, out_of_memory ? "out of memory" : "framebuffer incomplete");
+            report += msg_buf;
+        }
+        else {
+            glViewport(0, 0, size, size);
+            sprintf(msg_buf, "%dx%d:", size, size);
+            std::string line = msg_buf;
+            for(int m = 0; m < num_masks; m++) {
+                GPUTimer timer;
+                InitGPUTimer(&timer);
+                std::vector<double> samples;
+                glFinish();
+                double bench_start = GetTime();
+                for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+                    // Alternate the values so the driver can't skip a clear
+                    // which wouldn't change anything.
+                    glClearColor((GLclampf)(i & 1), 0.f, 0.f, 1.f);
+                    glClearDepth((i & 1) ? 1.0 : 0.5);
+                    glClearStencil(i & 1);
+                    BeginGPUTimer(&timer);
+                    double start = GetTime();
+                    glClear(masks[m]);
+                    EndGPUTimer(&timer);
+                    glFinish();
+                    samples.push_back(GetTime() - start);
+                }
+                TimingStats stats;
+                ComputeTimingStats(samples, &stats);
+                double bandwidth = mask_bytes[m] * size * size / stats.median / 1e9;
+                sprintf(msg_buf, "%s %s %.3f ms (%.1f GB/s)", m ? "," : "", mask_names[m], stats.median * 1000.0, bandwidth);
+                line += msg_buf;
+                DestroyGPUTimer(&timer);
+
+                if (masks[m] == GL_COLOR_BUFFER_BIT) {
+                    if (bandwidth > best_bandwidth)
+                        best_bandwidth = bandwidth;
+                    if (bandwidth >= best_bandwidth / 2)
+                        last_good_size = size;
+                }
+            }
+            report += line + "\n";
+        }
+
+        gl.BindFramebuffer(GL_FRAMEBUFFER, 0);
+        gl.DeleteFramebuffers(1, &fbo);
+        gl.DeleteRenderbuffers(2, renderbuffers);
+        if (out_of_memory || size == max_size)
+            break;
+    }
+    glClearColor(0.f, 0.f, 0.f, 0.f);
+    glClearDepth(1.0);
+    glClearStencil(0);
+
+    sprintf(msg_buf, "Largest size clearing at half the best color bandwidth or more: %dx%d\n", last_good_size, last_good_size);
+    report += msg_buf;
+    ReportInfo("Benchmark", report);
+}
+
+// Objects the state change benchmark flips between. Everything comes in
+// pairs so each change can alternate between two equally valid values.
+typedef struct StateChangeObjectsStruct
+{
+    GLuint textures[2];
+    GLuint index_buffers[2];
+    GLuint vertex_buffers[2];
+    GLuint programs[2];
+    int width, height;
+} StateChangeObjects;
+
+enum StateChange
+{
+    STATE_TEXTURE,
+    STATE_INDEX_BUFFER,
+    STATE_BLEND,
+    STATE_DEPTH_FUNC,
+    STATE_VIEWPORT,
+    STATE_SCISSOR,
+    STATE_PROGRAM,
+    STATE_ATTRIB_POINTER,
+    NUM_STATE_CHANGES
+};
+
+static const char* state_change_names[NUM_STATE_CHANGES] = {
+    "texture", "index buf", "blend", "depth func", "viewport", "scissor", "program", "attrib ptr",
+};
+
+static void ChangeState(int state, int phase, const StateChangeObjects* objects) {
+    switch (state) {
+    case STATE_TEXTURE:
+        glBindTexture(GL_TEXTURE_2D, objects->textures[phase]);
+        break;
+    case STATE_INDEX_BUFFER:
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, objects->index_buffers[phase]);
+        break;
+    case STATE_BLEND:
+        if (phase)
+            glEnable(GL_BLEND);
+        else
+            glDisable(GL_BLEND);
+        break;
+    case STATE_DEPTH_FUNC:
+        glDepthFunc(phase ? GL_LEQUAL : GL_ALWAYS);
+        break;
+    case STATE_VIEWPORT:
+        glViewport(0, 0, objects->width >> phase, objects->height >> phase);
+        break;
+    case STATE_SCISSOR:
+        glScissor(phase, phase, objects->width - phase, objects->height - phase);
+        break;
+    case STATE_PROGRAM:
+        gl.UseProgram(objects->programs[phase]);
+        break;
+    case STATE_ATTRIB_POINTER:
+        gl.BindBuffer(GL_ARRAY_BUFFER, objects->vertex_buffers[phase]);
+        gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+        break;
+    }
+}
+
+// Renderers sort draws by state, and the sort keys should reflect what each
+// change actually costs. Issues tiny draws with one or two kinds of state
+// flipping between every draw, and reports a matrix of the extra time per
+// draw over draws with no changes at all. The diagonal is the cost of each
+// change alone, the rest shows whether pairs of changes cost more or less
+// than the sum of their parts.
+void BenchmarkStateChanges() {
+    const int draws_per_frame = 2000;
+    const int triangles = 256;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "State changes: framebuffer objects not available.");
+        return;
+    }
+
+    StateChangeObjects objects;
+    objects.width = objects.height = 64;
+    for(int p = 0; p < 2; p++) {
+        objects.programs[p] = CreateProgram(fullscreen_vertex_shader, textured_fragment_shader, NULL);
+        if (objects.programs[p] == 0) {
+            if (p == 1)
+                gl.DeleteProgram(objects.programs[0]);
+            ReportInfo("Benchmark", "State changes: shader failed to compile.");
+            return;
+        }
+    }
+
+    Framebuffer fb;
+    bool complete = CreateFramebuffer(&fb, objects.width, objects.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+    GLuint depth;
+    gl.GenRenderbuffers(1, &depth);
+    gl.BindRenderbuffer(GL_RENDERBUFFER, depth);
+    gl.RenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, objects.width, objects.height);
+    gl.BindRenderbuffer(GL_RENDERBUFFER, 0);
+    gl.FramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+    if (!complete || gl.CheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteRenderbuffers(1, &depth);
+        gl.DeleteProgram(objects.programs[0]);
+        gl.DeleteProgram(objects.programs[1]);
+        ReportInfo("Benchmark", "State changes: framebuffer incomplete.");
+        return;
+    }
+
+    // Tiny triangles as in the draw call benchmark. The second index buffer
+    // walks the same triangles backwards.
+    std::vector<GLfloat> vertices;
+    std::vector<GLushort> indices[2];
+    for(int t = 0; t < triangles; t++) {
+        float x = -1.f + 2.f * t / triangles;
+        GLfloat tri[] = { x, -1.f, x + 0.005f, -1.f, x, -0.995f };
+        vertices.insert(vertices.end(), tri, tri + 6);
+        for(int v = 0; v < 3; v++) {
+            indices[0].push_back((GLushort)(t * 3 + v));
+            indices[1].push_back((GLushort)((triangles - 1 - t) * 3 + v));
+        }
+    }
+    gl.GenBuffers(2, objects.vertex_buffers);
+    gl.GenBuffers(2, objects.index_buffers);
+    for(int b = 0; b < 2; b++) {
+        gl.BindBuffer(GL_ARRAY_BUFFER, objects.vertex_buffers[b]);
+        gl.BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+        gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, objects.index_buffers[b]);
+        gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, indices[b].size() * sizeof(GLushort), &indices[b][0], GL_STATIC_DRAW);
+    }
+
+    glGenTextures(2, objects.textures);
+    for(int t = 0; t < 2; t++) {
+        GLubyte texels[4 * 4 * 4];
+        memset(texels, t ? 0xff : 0x40, sizeof(texels));
+        glBindTexture(GL_TEXTURE_2D, objects.textures[t]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 4, 4, 0, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+    }
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+    glBlendFunc(GL_ONE, GL_ONE);
+    gl.EnableVertexAttribArray(0);
+
+    // Entry [i][j] flips states i and j before every draw, NUM_STATE_CHANGES
+    // is used for no change.
+    double frame_times[NUM_STATE_CHANGES + 1][NUM_STATE_CHANGES + 1];
+    std::string baseline_times;
+    for(int i = NUM_STATE_CHANGES; i >= 0; i--) {
+        for(int j = i; j <= NUM_STATE_CHANGES; j++) {
+            if (j == NUM_STATE_CHANGES && i != NUM_STATE_CHANGES)
+                continue;
+            // Start every run from the same state.
+            for(int s = 0; s < NUM_STATE_CHANGES; s++)
+                ChangeState(s, 0, &objects);
+
+            std::vector<double> samples;
+            GPUTimer timer;
+            InitGPUTimer(&timer);
+            glFinish();
+            double bench_start = GetTime();
+            for(int iteration = 0; KeepBenchmarking(iteration, bench_start); iteration++) {
+                BeginGPUTimer(&timer);
+                double start = GetTime();
+                for(int d = 0; d < draws_per_frame; d++) {
+                    if (i != NUM_STATE_CHANGES)
+                        ChangeState(i, d & 1, &objects);
+                    if (j != i && j != NUM_STATE_CHANGES)
+                        ChangeState(j, d & 1, &objects);
+                    int t = d % triangles;
+                    glDrawElements(GL_TRIANGLES, 3, GL_UNSIGNED_SHORT, (const void*)(t * 3 * sizeof(GLushort)));
+                }
+                EndGPUTimer(&timer);
+                glFinish();
+                samples.push_back(GetTime() - start);
+            }
+            TimingStats stats;
+            ComputeTimingStats(samples, &stats);
+            frame_times[i][j] = frame_times[j][i] = stats.median;
+            if (i == NUM_STATE_CHANGES)
+                baseline_times = FormatGPUTimer(&timer);
+            DestroyGPUTimer(&timer);
+        }
+    }
+
+    double baseline = frame_times[NUM_STATE_CHANGES][NUM_STATE_CHANGES];
+    std::string report = "State changes (extra ns per draw):\n";
+    sprintf(msg_buf, "No changes: %.0f ns per draw, %s per %d draws\n", baseline * 1e9 / draws_per_frame,
+        baseline_times.c_str(), draws_per_frame);
+    report += msg_buf;
+    sprintf(msg_buf, "%-11s", "");
+    report += msg_buf;
+    for(int j = 0; j < NUM_STATE_CHANGES; j++) {
+        sprintf(msg_buf, "%11s", state_change_names[j]);
+        report += msg_buf;
+    }
+    report += "\n";
+    for(int i = 0; i < NUM_STATE_CHANGES; i++) {
+        sprintf(msg_buf, "%-11s", state_change_names[i]);
+        report += msg_buf;
+        for(int j = 0; j < NUM_STATE_CHANGES; j++) {
+            sprintf(msg_buf, "%11.0f", (frame_times[i][j] - baseline) * 1e9 / draws_per_frame);
+            report += msg_buf;
+        }
+        report += "\n";
+    }
+
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glDepthFunc(GL_LESS);
+    glBlendFunc(GL_ONE, GL_ZERO);
+    gl.UseProgram(0);
+    gl.DisableVertexAttribArray(0);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    DestroyFramebuffer(&fb);
+    gl.DeleteRenderbuffers(1, &depth);
+    glDeleteTextures(2, objects.textures);
+    gl.DeleteBuffers(2, objects.vertex_buffers);
+    gl.DeleteBuffers(2, objects.index_buffers);
+    gl.DeleteProgram(objects.programs[0]);
+    gl.DeleteProgram(objects.programs[1]);
+    ReportInfo("Benchmark", report);
+}
+
+// Per draw uniforms for the uniform update benchmark: a model matrix and four
+// vectors of material parameters, declared loose or as a std140 block.
+static const char* loose_uniforms_vertex_shader =
+    "#version 120\n"
+    "attribute vec4 position;\n"
+    "uniform mat4 model;\n"
+    "uniform vec4 params[4];\n"
+    "varying vec4 color;\n"
+    "void main() {\n"
+    "    color = params[0] * params[1] + params[2] * params[3];\n"
+    "    gl_Position = model * position;\n"
+    "}\n";
+
+static const char* block_uniforms_vertex_shader =
+    "#version 120\n"
+    "#extension GL_ARB_uniform_buffer_object : enable\n"
+    "attribute vec4 position;\n"
+    "layout(std140) uniform PerDraw {\n"
+    "    mat4 model;\n"
+    "    vec4 params[4];\n"
+    "};\n"
+    "varying vec4 color;\n"
+    "void main() {\n"
+    "    color = params[0] * params[1] + params[2] * params[3];\n"
+    "    gl_Position = model * position;\n"
+    "}\n";
+
+static const char* color_fragment_shader =
+    "#version 120\n"
+    "varying vec4 color;\n"
+    "void main() { gl_FragColor = color; }\n";
+
+// Scene graph renderers update a handful of uniforms before every draw, and
+// WebGL 2 lets them use uniform buffers instead. Compares a glUniform* call
+// per uniform against a glBufferSubData and glBindBufferRange per draw, and
+// against one glBufferSubData for the whole frame with just the
+// glBindBufferRange per draw.
+void BenchmarkUniformUpdates() {
+    const int draws_per_frame = 5000;
+    // One mat4 and four vec4s, counted as five uniforms.
+    const int uniforms_per_draw = 5;
+    const int floats_per_draw = 16 + 4 * 4;
+    const int triangles = 256;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Uniform updates: framebuffer objects not available.");
+        return;
+    }
+    bool have_ubo = HasGLVersion(3, 1) || HasGLExtension("GL_ARB_uniform_buffer_object");
+
+    GLuint loose_program = CreateProgram(loose_uniforms_vertex_shader, color_fragment_shader, NULL);
+    GLuint block_program = have_ubo ? CreateProgram(block_uniforms_vertex_shader, color_fragment_shader, NULL) : 0;
+    if (loose_program == 0) {
+        if (block_program != 0)
+            gl.DeleteProgram(block_program);
+        ReportInfo("Benchmark", "Uniform updates: shader failed to compile.");
+        return;
+    }
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, 256, 256, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(loose_program);
+        if (block_program != 0)
+            gl.DeleteProgram(block_program);
+        ReportInfo("Benchmark", "Uniform updates: framebuffer incomplete.");
+        return;
+    }
+    GLint model_location = gl.GetUniformLocation(loose_program, "model");
+    // Array elements aren't guaranteed consecutive locations before GL 4.3.
+    GLint params_locations[4];
+    for(int p = 0; p < 4; p++) {
+        char name[16];
+        sprintf(name, "params[%d]", p);
+        params_locations[p] = gl.GetUniformLocation(loose_program, name);
+    }
+
+    // Different values for every draw, so the driver can't skip redundant
+    // updates. The matrices scale the triangles down and move them around.
+    std::vector<GLfloat> draw_data(draws_per_frame * floats_per_draw);
+    for(int d = 0; d < draws_per_frame; d++) {
+        GLfloat* data = &draw_data[d * floats_per_draw];
+        for(int f = 0; f < floats_per_draw; f++)
+            data[f] = 0.f;
+        data[0] = data[5] = 0.01f;
+        data[10] = data[15] = 1.f;
+        data[12] = -1.f + 2.f * (d % 97) / 97.f;
+        data[13] = -1.f + 2.f * (d % 89) / 89.f;
+        for(int f = 16; f < floats_per_draw; f++)
+            data[f] = (GLfloat)((d + f) % 16) / 16.f;
+    }
+
+    std::vector<GLfloat> vertices;
+    for(int t = 0; t < triangles; t++) {
+        GLfloat tri[] = { 0.f, 0.f, 1.f, 0.f, 0.f, 1.f };
+        vertices.insert(vertices.end(), tri, tri + 6);
+    }
+    GLuint vertex_buffer;
+    gl.GenBuffers(1, &vertex_buffer);
+    gl.BindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    gl.BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    gl.EnableVertexAttribArray(0);
+
+    // Each draw's block has to start on the alignment the driver asks for.
+    GLuint uniform_buffer = 0;
+    GLsizeiptr block_size = floats_per_draw * sizeof(GLfloat);
+    GLsizeiptr block_stride = block_size;
+    if (block_program != 0) {
+        GLint alignment = 1;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment > 0)
+            block_stride = (block_size + alignment - 1) / alignment * alignment;
+        gl.UniformBlockBinding(block_program, gl.GetUniformBlockIndex(block_program, "PerDraw"), 0);
+        gl.GenBuffers(1, &uniform_buffer);
+        gl.BindBuffer(GL_UNIFORM_BUFFER, uniform_buffer);
+        gl.BufferData(GL_UNIFORM_BUFFER, block_stride * draws_per_frame, NULL, GL_DYNAMIC_DRAW);
+    }
+    // The whole frame laid out at the buffer's stride, for the batched upload.
+    std::vector<GLubyte> frame_data(block_stride * draws_per_frame);
+    for(int d = 0; d < draws_per_frame; d++)
+        memcpy(&frame_data[d * block_stride], &draw_data[d * floats_per_draw], block_size);
+
+    static const char* mode_names[] = {
+        "glUniform*",
+        "glBufferSubData + glBindBufferRange per draw",
+        "glBufferSubData per frame + glBindBufferRange per draw",
+    };
+    std::string report = "Uniform updates:\n";
+    for(int mode = 0; mode < 3; mode++) {
+        if (mode > 0 && block_program == 0) {
+            sprintf(msg_buf, "%s: %s\n", mode_names[mode], have_ubo ? "shader failed to compile" : "uniform buffers not available");
+            report += msg_buf;
+            continue;
+        }
+        gl.UseProgram(mode == 0 ? loose_program : block_program);
+
+        std::vector<double> samples;
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        glFinish();
+        double bench_start = GetTime();
+        for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+            BeginGPUTimer(&timer);
+            double start = GetTime();
+            if (mode == 2)
+                gl.BufferSubData(GL_UNIFORM_BUFFER, 0, frame_data.size(), &frame_data[0]);
+            for(int d = 0; d < draws_per_frame; d++) {
+                const GLfloat* data = &draw_data[d * floats_per_draw];
+                GLintptr offset = d * block_stride;
+                if (mode == 0) {
+                    gl.UniformMatrix4fv(model_location, 1, GL_FALSE, data);
+                    for(int p = 0; p < 4; p++)
+                        gl.Uniform4fv(params_locations[p], 1, data + 16 + p * 4);
+                }
+                else {
+                    if (mode == 1)
+                        gl.BufferSubData(GL_UNIFORM_BUFFER, offset, block_size, data);
+                    gl.BindBufferRange(GL_UNIFORM_BUFFER, 0, uniform_buffer, offset, block_size);
+                }
+                glDrawArrays(GL_TRIANGLES, (d % triangles) * 3, 3);
+            }
+            EndGPUTimer(&timer);
+            glFinish();
+            samples.push_back(GetTime() - start);
+        }
+        TimingStats submit, total;
+        ComputeTimingStats(timer.cpu_samples, &submit);
+        ComputeTimingStats(samples, &total);
+        sprintf(msg_buf, "%s: %.0f draws/s, %.0f uniforms/s, %.3f us CPU per draw, %s per frame\n",
+            mode_names[mode], draws_per_frame / total.median, draws_per_frame * uniforms_per_draw / total.median,
+            submit.median * 1e6 / draws_per_frame, FormatGPUTimer(&timer).c_str());
+        report += msg_buf;
+        DestroyGPUTimer(&timer);
+    }
+
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DisableVertexAttribArray(0);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    gl.DeleteBuffers(1, &vertex_buffer);
+    if (uniform_buffer != 0) {
+        gl.BindBuffer(GL_UNIFORM_BUFFER, 0);
+        gl.DeleteBuffers(1, &uniform_buffer);
+    }
+    gl.DeleteProgram(loose_program);
+    if (block_program != 0)
+        gl.DeleteProgram(block_program);
+    ReportInfo("Benchmark", report);
+}
+
+// Moves each copy of the mesh by a per instance offset. The instanced path
+// feeds offset from an array with a divisor of one, the individual path sets
+// it with glVertexAttrib before each draw.
+static const char* instanced_vertex_shader =
+    "#version 120\n"
+    "attribute vec4 position;\n"
+    "attribute vec2 offset;\n"
+    "void main() {\n"
+    "    gl_Position = vec4(position.xy + offset, 0.0, 1.0);\n"
+    "}\n";
+
+// Particles and foliage draw the same mesh many times, which WebGL content
+// does with ANGLE_instanced_arrays when it can. Draws increasing numbers of
+// copies of a small mesh with one instanced draw and with one draw per copy,
+// and reports instances/s for both.
+void BenchmarkInstancing() {
+    static const int instance_counts[] = { 10, 100, 1000, 10000 };
+    const int num_instance_counts = sizeof(instance_counts) / sizeof(instance_counts[0]);
+    const int max_instances = instance_counts[num_instance_counts - 1];
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Instancing: framebuffer objects not available.");
+        return;
+    }
+    // Instanced arrays give us the divisor, glDrawArraysInstanced comes from
+    // GL 3.1 or ARB_draw_instanced.
+    bool have_instancing = HasGLVersion(3, 3) || (HasGLExtension("GL_ARB_instanced_arrays") &&
+        (HasGLVersion(3, 1) || HasGLExtension("GL_ARB_draw_instanced")));
+
+    GLuint program = CreateProgram(instanced_vertex_shader, trivial_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Instancing: shader failed to compile.");
+        return;
+    }
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, 256, 256, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Instancing: framebuffer incomplete.");
+        return;
+    }
+    GLint offset_location = gl.GetAttribLocation(program, "offset");
+
+    // A small hexagon as a triangle fan, and a grid of offsets covering the
+    // target.
+    std::vector<GLfloat> mesh;
+    mesh.push_back(0.f);
+    mesh.push_back(0.f);
+    for(int v = 0; v <= 6; v++) {
+        mesh.push_back(0.01f * (GLfloat)cos(v * 3.14159265 / 3));
+        mesh.push_back(0.01f * (GLfloat)sin(v * 3.14159265 / 3));
+    }
+    const int mesh_vertices = (int)mesh.size() / 2;
+    std::vector<GLfloat> offsets;
+    for(int i = 0; i < max_instances; i++) {
+        offsets.push_back(-1.f + 2.f * (i % 100) / 100.f);
+        offsets.push_back(-1.f + 2.f * (i / 100) / 100.f);
+    }
+
+    GLuint buffers[2];
+    gl.GenBuffers(2, buffers);
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+    gl.BufferData(GL_ARRAY_BUFFER, mesh.size() * sizeof(GLfloat), &mesh[0], GL_STATIC_DRAW);
+    gl.VertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    gl.EnableVertexAttribArray(0);
+    gl.BindBuffer(GL_ARRAY_BUFFER, buffers[1]);
+    gl.BufferData(GL_ARRAY_BUFFER, offsets.size() * sizeof(GLfloat), &offsets[0], GL_STATIC_DRAW);
+    gl.VertexAttribPointer(offset_location, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    gl.UseProgram(program);
+
+    std::string report = "Instancing:\n";
+    report += have_instancing ? "Instanced arrays: available\n" :
+        "Instanced arrays: not available, only individual draws measured\n";
+    for(int c = 0; c < num_instance_counts; c++) {
+        int instances = instance_counts[c];
+        double rates[2] = { 0, 0 };
+        std::string times[2];
+        for(int instanced = 0; instanced < 2; instanced++) {
+            if (instanced && !have_instancing)
+                continue;
+            if (instanced) {
+                gl.EnableVertexAttribArray(offset_location);
+                gl.VertexAttribDivisor(offset_location, 1);
+            }
+
+            std::vector<double> samples;
+            GPUTimer timer;
+            InitGPUTimer(&timer);
+            glFinish();
+            double bench_start = GetTime();
+            for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+                BeginGPUTimer(&timer);
+                double start = GetTime();
+                if (instanced) {
+                    gl.DrawArraysInstanced(GL_TRIANGLE_FAN, 0, mesh_vertices, instances);
+                }
+                else {
+                    for(int n = 0; n < instances; n++) {
+                        gl.VertexAttrib2fv(offset_location, &offsets[n * 2]);
+                        glDrawArrays(GL_TRIANGLE_FAN, 0, mesh_vertices);
+                    }
+                }
+                EndGPUTimer(&timer);
+                glFinish();
+                samples.push_back(GetTime() - start);
+            }
+            TimingStats stats;
+            ComputeTimingStats(samples, &stats);
+            rates[instanced] = instances / stats.median;
+            times[instanced] = FormatGPUTimer(&timer);
+            DestroyGPUTimer(&timer);
+
+            if (instanced) {
+                gl.VertexAttribDivisor(offset_location, 0);
+                gl.DisableVertexAttribArray(offset_location);
+            }
+        }
+
+        sprintf(msg_buf, "%d instances: individual %.0f instances/s (%s)", instances, rates[0], times[0].c_str());
+        report += msg_buf;
+        if (have_instancing) {
+            sprintf(msg_buf, ", instanced %.0f instances/s (%s), %.1fx", rates[1], times[1].c_str(), rates[1] / rates[0]);
+            report += msg_buf;
+        }
+        report += "\n";
+    }
+
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DisableVertexAttribArray(0);
+    gl.DeleteBuffers(2, buffers);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+static const char* translucent_fragment_shader =
+    "#version 120\n"
+    "void main() { gl_FragColor = vec4(0.1, 0.2, 0.3, 0.5); }\n";
+
+// Transparent UI and particles blend every pixel, and how much that costs
+// over plain writes varies a lot, especially on software rasterizers. Draws
+// layers of full screen quads at 1080p with each common blend mode and
+// reports Mpixels/s and the slowdown against blending disabled.
+void BenchmarkBlending() {
+    struct BlendMode {
+        const char* name;
+        bool enabled;
+        GLenum src_rgb, dst_rgb, src_alpha, dst_alpha;
+    };
+    static const BlendMode modes[] = {
+        { "disabled", false, GL_ONE, GL_ZERO, GL_ONE, GL_ZERO },
+        { "alpha", true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA },
+        { "premultiplied alpha", true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA },
+        { "additive", true, GL_ONE, GL_ONE, GL_ONE, GL_ONE },
+        { "separate rgb/alpha", true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA },
+    };
+    const int num_modes = sizeof(modes) / sizeof(modes[0]);
+    const int layers = 4;
+    const CanvasSize& size = canvas_sizes[1];
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Blending: framebuffer objects not available.");
+        return;
+    }
+
+    GLuint program = CreateProgram(fullscreen_vertex_shader, translucent_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Blending: shader failed to compile.");
+        return;
+    }
+
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, size.width, size.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Blending: framebuffer incomplete.");
+        return;
+    }
+    gl.UseProgram(program);
+
+    sprintf(msg_buf, "Blending at %s:\n", size.name);
+    std::string report = msg_buf;
+    double opaque_rate = 0;
+    for(int m = 0; m < num_modes; m++) {
+        const BlendMode& mode = modes[m];
+        if (mode.enabled)
+            glEnable(GL_BLEND);
+        else
+            glDisable(GL_BLEND);
+        gl.BlendFuncSeparate(mode.src_rgb, mode.dst_rgb, mode.src_alpha, mode.dst_alpha);
+        DrawFullscreenQuad();
+        glFinish();
+
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        double bench_start = GetTime();
+        int passes;
+        for(passes = 0; KeepBenchmarking(passes, bench_start); passes++) {
+            BeginGPUTimer(&timer);
+            for(int l = 0; l < layers; l++)
+                DrawFullscreenQuad();
+            EndGPUTimer(&timer);
+        }
+        FinishGPUTimer(&timer);
+        glFinish();
+        double elapsed = GetTime() - bench_start;
+        double rate = (double)passes * layers * size.width * size.height / 1e6 / elapsed;
+        sprintf(msg_buf, "%s: %.1f Mpixels/s, %s per %d layers", mode.name, rate, FormatGPUTimer(&timer).c_str(), layers);
+        report += msg_buf;
+        if (m == 0) {
+            opaque_rate = rate;
+            report += "\n";
+        }
+        else {
+            sprintf(msg_buf, ", %.2fx slower than disabled\n", opaque_rate / rate);
+            report += msg_buf;
+        }
+        DestroyGPUTimer(&timer);
+    }
+
+    glDisable(GL_BLEND);
+    gl.BlendFuncSeparate(GL_ONE, GL_ZERO, GL_ONE, GL_ZERO);
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Box filters a full mip chain of an RGBA8 image on the CPU, returning how
+// long it took. A driver generating mipmaps slower than this is almost
+// certainly doing it on the CPU itself, and badly.
+static double TimeCPUMipmapChain(int size) {
+    std::vector<unsigned char> src((size_t)size * size * 4, 0x3c);
+    std::vector<unsigned char> dst;
+    double start = GetTime();
+    for(int level_size = size; level_size > 1; level_size /= 2) {
+        int half_size = level_size / 2;
+        dst.resize((size_t)half_size * half_size * 4);
+        for(int y = 0; y < half_size; y++) {
+            const unsigned char* row0 = &src[(size_t)(y * 2) * level_size * 4];
+            const unsigned char* row1 = row0 + level_size * 4;
+            unsigned char* out = &dst[(size_t)y * half_size * 4];
+            for(int x = 0; x < half_size * 4; x++) {
+                int c = (x / 4) * 8 + (x % 4);
+                out[x] = (unsigned char)((row0[c] + row0[c + 4] + row1[c] + row1[c + 4] + 2) / 4);
+            }
+        }
+        src.swap(dst);
+    }
+    return GetTime() - start;
+}
+
+// Content which uploads an image and immediately calls generateMipmap stalls
+// until the chain is built, and some drivers quietly build it on the CPU.
+// Times glGenerateMipmap, or re-uploading with GL_GENERATE_MIPMAP set on
+// drivers without it, for textures of increasing size and several formats,
+// and flags anything slower than a plain CPU box filter.
+void BenchmarkMipmapGeneration() {
+    struct MipmapFormat {
+        const char* name;
+        GLenum internal_format, format, type;
+        int bytes_per_pixel;
+        bool is_float;
+    };
+    static const MipmapFormat formats[] = {
+        { "RGBA8", GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, 4, false },
+        { "RGBA16F", GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT, 8, true },
+        { "RGBA32F", GL_RGBA32F, GL_RGBA, GL_FLOAT, 16, true },
+    };
+    static const int sizes[] = { 256, 512, 1024, 2048, 4096 };
+
+    bool have_generate_mipmap = HasFramebufferObjects();
+    bool have_auto_mipmap = HasGLVersion(1, 4) || HasGLExtension("GL_SGIS_generate_mipmap");
+    if (!have_generate_mipmap && !have_auto_mipmap) {
+        ReportInfo("Benchmark", "Mipmap generation: not available.");
+        return;
+    }
+    bool have_float = HasFloatTextures();
+    GLint max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Best of a few runs, since a single run of the reference is noisy.
+    const int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+    double cpu_times[num_sizes];
+    for(int sz = 0; sz < num_sizes; sz++) {
+        cpu_times[sz] = TimeCPUMipmapChain(sizes[sz]);
+        for(int run = 1; run < 3; run++)
+            cpu_times[sz] = std::min(cpu_times[sz], TimeCPUMipmapChain(sizes[sz]));
+    }
+
+    std::string report = have_generate_mipmap ? "Mipmap generation (glGenerateMipmap):\n" :
+        "Mipmap generation (GL_GENERATE_MIPMAP, upload time subtracted):\n";
+    for(size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        const MipmapFormat& format = formats[f];
+        if (format.is_float && !have_float) {
+            sprintf(msg_buf, "%s: unsupported\n", format.name);
+            report += msg_buf;
+            continue;
+        }
+        for(int sz = 0; sz < num_sizes; sz++) {
+            int size = sizes[sz];
+            if (size > max_size)
+                break;
+            size_t bytes = (size_t)size * size * format.bytes_per_pixel;
+            std::vector<unsigned char> data(bytes, 0x3c);
+
+            GLuint tex;
+            glGenTextures(1, &tex);
+            glBindTexture(GL_TEXTURE_2D, tex);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, size, size, 0, format.format, format.type, &data[0]);
+
+            // Without glGenerateMipmap the chain is only built by an upload,
+            // so time the same uploads without it and take the difference.
+            std::vector<double> upload_samples, samples;
+            GPUTimer timer;
+            InitGPUTimer(&timer);
+            glFinish();
+            double bench_start = GetTime();
+            for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+                if (have_generate_mipmap) {
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, format.format, format.type, &data[0]);
+                    glFinish();
+                }
+                else {
+                    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_FALSE);
+                    double start = GetTime();
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, format.format, format.type, &data[0]);
+                    glFinish();
+                    upload_samples.push_back(GetTime() - start);
+                    glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+                }
+                BeginGPUTimer(&timer);
+                double start = GetTime();
+                if (have_generate_mipmap)
+                    gl.GenerateMipmap(GL_TEXTURE_2D);
+                else
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size, size, format.format, format.type, &data[0]);
+                EndGPUTimer(&timer);
+                glFinish();
+                samples.push_back(GetTime() - start);
+            }
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glDeleteTextures(1, &tex);
+
+            TimingStats stats, upload;
+            ComputeTimingStats(samples, &stats);
+            ComputeTimingStats(upload_samples, &upload);
+            double elapsed = stats.median - upload.median;
+            if (elapsed < 1e-9)
+                elapsed = 1e-9;
+            double mb_per_second = bytes / elapsed / 1e6;
+            // The CPU reference only filters RGBA8, so compare time for the
+            // same number of pixels rather than bytes, which would flag the
+            // wider formats just for moving more data.
+            sprintf(msg_buf, "%s %dx%d: %.3f ms, %.0f MB/s (%s)%s\n", format.name, size, size,
+                elapsed * 1000.0, mb_per_second, FormatGPUTimer(&timer).c_str(),
+                elapsed > cpu_times[sz] ? ", slower than a CPU box filter" : "");
+            report += msg_buf;
+            DestroyGPUTimer(&timer);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    ReportInfo("Benchmark", report);
+}
+
+// Takes eight samples per pixel from a texture minified twice as much
+// vertically as horizontally, so mip selection and anisotropy both matter.
+// With randomize set every 2x2 quad jumps to a different part of the texture,
+// which defeats the texture cache without changing the derivatives (the
+// jump is the same across the quad).
+static const char* sampling_fragment_shader =
+    "#version 120\n"
+    "uniform sampler2D tex;\n"
+    "uniform float randomize;\n"
+    "varying vec2 uv;\n"
+    "float hash(vec2 p) { return fract(sin(dot(p, vec2(12.9898, 78.233))) * 43758.5453); }\n"
+    "void main() {\n"
+    "    vec2 quad = floor(gl_FragCoord.xy * 0.5);\n"
+    "    vec4 sum = vec4(0.0);\n"
+    "    for (int i = 0; i < 8; i++) {\n"
+    "        vec2 jump = vec2(hash(quad + float(i)), hash(quad - float(i))) * randomize;\n"
+    "        sum += texture2D(tex, uv * vec2(2.0, 4.0) + jump + float(i) * 0.001);\n"
+    "    }\n"
+    "    gl_FragColor = sum * 0.125;\n"
+    "}\n";
+
+// Filtering quality is a per host tradeoff, and software renderers in
+// particular pay heavily for each extra texel. Samples a mipmapped texture
+// with nearest, bilinear, trilinear and each supported level of anisotropic
+// filtering, with coherent and random access, and reports texture lookups
+// per second.
+void BenchmarkTextureSampling() {
+    const int texture_size = 2048;
+    const int target_size = 1024;
+    const int samples_per_pixel = 8;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Texture sampling: framebuffer objects not available.");
+        return;
+    }
+    GLuint program = CreateProgram(fullscreen_vertex_shader, sampling_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Texture sampling: shader failed to compile.");
+        return;
+    }
+
+    struct SamplingFilter {
+        std::string name;
+        GLenum min_filter, mag_filter;
+        GLfloat anisotropy;
+    };
+    std::vector<SamplingFilter> filters;
+    SamplingFilter nearest = { "nearest", GL_NEAREST, GL_NEAREST, 1.f };
+    SamplingFilter bilinear = { "bilinear", GL_LINEAR, GL_LINEAR, 1.f };
+    SamplingFilter trilinear = { "trilinear", GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, 1.f };
+    filters.push_back(nearest);
+    filters.push_back(bilinear);
+    filters.push_back(trilinear);
+    bool have_anisotropy = HasGLVersion(4, 6) || HasGLExtension("GL_EXT_texture_filter_anisotropic") ||
+        HasGLExtension("GL_ARB_texture_filter_anisotropic");
+    GLfloat max_anisotropy = 1.f;
+    if (have_anisotropy)
+        glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &max_anisotropy);
+    for(int level = 2; level <= max_anisotropy; level *= 2) {
+        sprintf(msg_buf, "%dx anisotropic", level);
+        SamplingFilter anisotropic = { msg_buf, GL_LINEAR_MIPMAP_LINEAR, GL_LINEAR, (GLfloat)level };
+        filters.push_back(anisotropic);
+    }
+
+    // Noise, so nothing along the way can compress it.
+    std::vector<unsigned char> texels((size_t)texture_size * texture_size * 4);
+    unsigned int seed = 12345;
+    for(size_t t = 0; t < texels.size(); t++) {
+        seed = seed * 1103515245 + 12345;
+        texels[t] = (unsigned char)(seed >> 16);
+    }
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, texture_size, texture_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, &texels[0]);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gl.GenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, target_size, target_size, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        glDeleteTextures(1, &tex);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Texture sampling: framebuffer incomplete.");
+        return;
+    }
+    gl.UseProgram(program);
+    gl.Uniform1i(gl.GetUniformLocation(program, "tex"), 0);
+    GLint randomize_location = gl.GetUniformLocation(program, "randomize");
+    glBindTexture(GL_TEXTURE_2D, tex);
+
+    sprintf(msg_buf, "Texture sampling (%dx%d RGBA8, %d lookups per pixel):\n", texture_size, texture_size, samples_per_pixel);
+    std::string report = msg_buf;
+    for(size_t f = 0; f < filters.size(); f++) {
+        const SamplingFilter& filter = filters[f];
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter.min_filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter.mag_filter);
+        if (have_anisotropy)
+            glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, filter.anisotropy);
+
+        report += filter.name + ":";
+        for(int random = 0; random < 2; random++) {
+            gl.Uniform1f(randomize_location, (GLfloat)random);
+            DrawFullscreenQuad();
+            glFinish();
+
+            GPUTimer timer;
+            InitGPUTimer(&timer);
+            double bench_start = GetTime();
+            int passes;
+            for(passes = 0; KeepBenchmarking(passes, bench_start); passes++) {
+                BeginGPUTimer(&timer);
+                DrawFullscreenQuad();
+                EndGPUTimer(&timer);
+            }
+            FinishGPUTimer(&timer);
+            glFinish();
+            double elapsed = GetTime() - bench_start;
+            double lookups = (double)passes * target_size * target_size * samples_per_pixel;
+            sprintf(msg_buf, "%s %s %.0f Mlookups/s (%s)", random ? "," : "", random ? "random" : "coherent",
+                lookups / elapsed / 1e6, FormatGPUTimer(&timer).c_str());
+            report += msg_buf;
+            DestroyGPUTimer(&timer);
+        }
+        report += "\n";
+    }
+
+    if (have_anisotropy)
+        glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1.f);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    glDeleteTextures(1, &tex);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Blur, simulation and post processing effects chain passes which each read
+// the previous pass's output. Renders a chain of passes per frame ping-ponging
+// between separate FBOs, and between textures attached in turn to a single
+// FBO, and reports passes/s. The cost per switch is the extra time per pass
+// over the same chain rendered into one target from a fixed texture.
+void BenchmarkPingPong() {
+    const int passes_per_frame = 16;
+    const int size = 512;
+    enum PingPongMode { NO_SWITCH, SEPARATE_FBOS, SWAP_ATTACHMENT };
+    struct PingPongConfig {
+        const char* name;
+        int mode;
+        int targets;
+    };
+    static const PingPongConfig configs[] = {
+        { "no switch", NO_SWITCH, 1 },
+        { "2 FBOs", SEPARATE_FBOS, 2 },
+        { "4 FBOs", SEPARATE_FBOS, 4 },
+        { "1 FBO, swapping attachments", SWAP_ATTACHMENT, 2 },
+    };
+    const int max_targets = 4;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Ping-pong: framebuffer objects not available.");
+        return;
+    }
+    GLuint program = CreateProgram(fullscreen_vertex_shader, textured_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Ping-pong: shader failed to compile.");
+        return;
+    }
+
+    // One spare texture as the fixed source for the no switch baseline.
+    Framebuffer fbs[max_targets + 1];
+    bool complete = true;
+    for(int t = 0; t <= max_targets; t++) {
+        complete = CreateFramebuffer(&fbs[t], size, size, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE) && complete;
+        glBindTexture(GL_TEXTURE_2D, fbs[t].tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (!complete) {
+        for(int t = 0; t <= max_targets; t++)
+            DestroyFramebuffer(&fbs[t]);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Ping-pong: framebuffer incomplete.");
+        return;
+    }
+    gl.UseProgram(program);
+    gl.Uniform1i(gl.GetUniformLocation(program, "tex"), 0);
+
+    std::string report = "Ping-pong:\n";
+    double baseline = 0;
+    for(size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        const PingPongConfig& config = configs[c];
+        if (config.mode == NO_SWITCH) {
+            gl.BindFramebuffer(GL_FRAMEBUFFER, fbs[0].fbo);
+            glBindTexture(GL_TEXTURE_2D, fbs[max_targets].tex);
+        }
+        else if (config.mode == SWAP_ATTACHMENT) {
+            gl.BindFramebuffer(GL_FRAMEBUFFER, fbs[0].fbo);
+        }
+
+        std::vector<double> samples;
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        glFinish();
+        double bench_start = GetTime();
+        for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+            BeginGPUTimer(&timer);
+            double start = GetTime();
+            for(int p = 0; p < passes_per_frame; p++) {
+                int target = p % config.targets;
+                int source = (p + config.targets - 1) % config.targets;
+                if (config.mode == SEPARATE_FBOS) {
+                    gl.BindFramebuffer(GL_FRAMEBUFFER, fbs[target].fbo);
+                    glBindTexture(GL_TEXTURE_2D, fbs[source].tex);
+                }
+                else if (config.mode == SWAP_ATTACHMENT) {
+                    gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fbs[target].tex, 0);
+                    glBindTexture(GL_TEXTURE_2D, fbs[source].tex);
+                }
+                DrawFullscreenQuad();
+            }
+            EndGPUTimer(&timer);
+            glFinish();
+            samples.push_back(GetTime() - start);
+        }
+        TimingStats stats;
+        ComputeTimingStats(samples, &stats);
+        sprintf(msg_buf, "%s: %.0f passes/s, %s per %d passes", config.name, passes_per_frame / stats.median,
+            FormatGPUTimer(&timer).c_str(), passes_per_frame);
+        report += msg_buf;
+        if (config.mode == NO_SWITCH) {
+            baseline = stats.median;
+            report += "\n";
+        }
+        else {
+            sprintf(msg_buf, ", %.1f us per switch\n", (stats.median - baseline) * 1e6 / passes_per_frame);
+            report += msg_buf;
+        }
+        DestroyGPUTimer(&timer);
+
+        if (config.mode == SWAP_ATTACHMENT)
+            gl.FramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fbs[0].tex, 0);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    gl.UseProgram(0);
+    for(int t = 0; t <= max_targets; t++)
+        DestroyFramebuffer(&fbs[t]);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Compositors wait for the GPU at least once a frame, so whatever a wait costs
+// on top of the work itself is a fixed cost per frame. Times each way of
+// waiting the driver offers, first with nothing queued, then right after
+// queueing a few full screen quads so the wait has to track real work.
+void BenchmarkSyncLatency() {
+    enum SyncMethod { SYNC_FINISH, SYNC_FENCE_SYNC, SYNC_NV_FENCE, SYNC_APPLE_FENCE };
+    static const char* method_names[] = {
+        "glFinish", "glFenceSync + glFlush + glClientWaitSync", "NV_fence", "APPLE_fence",
+    };
+    bool available[] = {
+        true,
+        HasGLVersion(3, 2) || HasGLExtension("GL_ARB_sync"),
+        HasGLExtension("GL_NV_fence"),
+        HasGLExtension("GL_APPLE_fence"),
+    };
+    const int load_layers = 4;
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Sync latency: framebuffer objects not available.");
+        return;
+    }
+    GLuint program = CreateProgram(fullscreen_vertex_shader, trivial_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Sync latency: shader failed to compile.");
+        return;
+    }
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, canvas_sizes[0].width, canvas_sizes[0].height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Sync latency: framebuffer incomplete.");
+        return;
+    }
+    gl.UseProgram(program);
+
+    GLuint fence = 0;
+    if (available[SYNC_NV_FENCE])
+        gl.GenFencesNV(1, &fence);
+    else if (available[SYNC_APPLE_FENCE])
+        gl.GenFencesAPPLE(1, &fence);
+
+    sprintf(msg_buf, "Sync latency (median / p99, loaded is %d layers at %s):\n", load_layers, canvas_sizes[0].name);
+    std::string report = msg_buf;
+    for(int method = SYNC_FINISH; method <= SYNC_APPLE_FENCE; method++) {
+        if (!available[method])
+            continue;
+        // Only one of the vendor fences gets a fence object, they're never
+        // both exposed in practice.
+        if (method == SYNC_APPLE_FENCE && available[SYNC_NV_FENCE])
+            continue;
+
+        report += method_names[method];
+        report += ":";
+        for(int loaded = 0; loaded < 2; loaded++) {
+            std::vector<double> samples;
+            glFinish();
+            double bench_start = GetTime();
+            for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+                if (loaded) {
+                    for(int l = 0; l < load_layers; l++)
+                        DrawFullscreenQuad();
+                }
+                double start = GetTime();
+                switch (method) {
+                case SYNC_FINISH:
+                    glFinish();
+                    break;
+                case SYNC_FENCE_SYNC: {
+                    GLsync sync = gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                    glFlush();
+                    gl.ClientWaitSync(sync, 0, (GLuint64)1000000000);
+                    gl.DeleteSync(sync);
+                    break;
+                }
+                case SYNC_NV_FENCE:
+                    gl.SetFenceNV(fence, GL_ALL_COMPLETED_NV);
+                    gl.FinishFenceNV(fence);
+                    break;
+                case SYNC_APPLE_FENCE:
+                    gl.SetFenceAPPLE(fence);
+                    gl.FinishFenceAPPLE(fence);
+                    break;
+                }
+                samples.push_back(GetTime() - start);
+            }
+            TimingStats stats;
+            ComputeTimingStats(samples, &stats);
+            sprintf(msg_buf, "%s %s %.1f / %.1f us", loaded ? "," : "", loaded ? "loaded" : "idle",
+                stats.median * 1e6, stats.p99 * 1e6);
+            report += msg_buf;
+        }
+        report += "\n";
+    }
+
+    if (fence != 0) {
+        if (available[SYNC_NV_FENCE])
+            gl.DeleteFencesNV(1, &fence);
+        else
+            gl.DeleteFencesAPPLE(1, &fence);
+    }
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Draws layers of full screen quads with whatever is bound until we have
+// enough samples, returning the wall time per layer over the whole run and
+// the CPU and GPU times per pass in times.
+static double TimeFullscreenLayers(int layers, std::string* times) {
+    DrawFullscreenQuad();
+    glFinish();
+
+    GPUTimer timer;
+    InitGPUTimer(&timer);
+    double bench_start = GetTime();
+    int passes;
+    for(passes = 0; KeepBenchmarking(passes, bench_start); passes++) {
+        BeginGPUTimer(&timer);
+        for(int l = 0; l < layers; l++)
+            DrawFullscreenQuad();
+        EndGPUTimer(&timer);
+    }
+    FinishGPUTimer(&timer);
+    glFinish();
+    double elapsed = GetTime() - bench_start;
+    *times = FormatGPUTimer(&timer);
+    DestroyGPUTimer(&timer);
+    return elapsed / (passes * layers);
+}
+
+// Float targets take two or four times the bandwidth of RGBA8 and some
+// hardware renders or filters them at a fraction of the rate. Renders into
+// and samples from 1080p half float and float textures, with RGBA8 for
+// comparison, and reports Mpixels/s.
+void BenchmarkFloatTextures() {
+    const int layers = 4;
+    const CanvasSize& size = canvas_sizes[1];
+
+    if (!HasFramebufferObjects() || !HasFloatTextures()) {
+        ReportInfo("Benchmark", "Float textures: not available.");
+        return;
+    }
+    GLuint render_program = CreateProgram(fullscreen_vertex_shader, trivial_fragment_shader, NULL);
+    GLuint sample_program = CreateProgram(fullscreen_vertex_shader, textured_fragment_shader, NULL);
+    if (render_program == 0 || sample_program == 0) {
+        if (render_program != 0)
+            gl.DeleteProgram(render_program);
+        if (sample_program != 0)
+            gl.DeleteProgram(sample_program);
+        ReportInfo("Benchmark", "Float textures: shader failed to compile.");
+        return;
+    }
+
+    FloatFormat formats[num_float_formats + 1] = { { "RGBA8", GL_RGBA8, GL_UNSIGNED_BYTE } };
+    for(int f = 0; f < num_float_formats; f++)
+        formats[f + 1] = float_formats[f];
+    double mpixels = (double)size.width * size.height / 1e6;
+
+    sprintf(msg_buf, "Float textures at %s:\n", size.name);
+    std::string report = msg_buf;
+    for(int f = 0; f <= num_float_formats; f++) {
+        const FloatFormat& format = formats[f];
+        std::string times;
+        Framebuffer fb;
+
+        report += format.name;
+        report += ":";
+        if (CreateFramebuffer(&fb, size.width, size.height, format.internal_format, GL_RGBA, format.type)) {
+            gl.UseProgram(render_program);
+            double per_layer = TimeFullscreenLayers(layers, &times);
+            sprintf(msg_buf, " render %.1f Mpixels/s (%s per %d layers),", mpixels / per_layer, times.c_str(), layers);
+            report += msg_buf;
+        }
+        else {
+            report += " render unsupported,";
+        }
+        gl.UseProgram(0);
+        DestroyFramebuffer(&fb);
+
+        // Sample the format with bilinear filtering into an RGBA8 target. The
+        // source is cleared through its own framebuffer, so it has to be
+        // renderable too.
+        Framebuffer source;
+        bool complete = CreateFramebuffer(&source, size.width, size.height, format.internal_format, GL_RGBA, format.type);
+        if (complete)
+            glClear(GL_COLOR_BUFFER_BIT);
+        complete = CreateFramebuffer(&fb, size.width, size.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE) && complete;
+        if (complete) {
+            glBindTexture(GL_TEXTURE_2D, source.tex);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            gl.UseProgram(sample_program);
+            gl.Uniform1i(gl.GetUniformLocation(sample_program, "tex"), 0);
+            double per_layer = TimeFullscreenLayers(layers, &times);
+            sprintf(msg_buf, " sample %.1f Mpixels/s (%s per %d layers)\n", mpixels / per_layer, times.c_str(), layers);
+            report += msg_buf;
+            gl.UseProgram(0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+        }
+        else {
+            report += " sample unsupported\n";
+        }
+        DestroyFramebuffer(&fb);
+        DestroyFramebuffer(&source);
+    }
+
+    gl.DeleteProgram(render_program);
+    gl.DeleteProgram(sample_program);
+    ReportInfo("Benchmark", report);
+}
+
+// Shipping compressed assets saves download size and GPU memory, but only if
+// the host samples them natively; drivers which emulate a format decompress
+// it on upload and keep it uncompressed. Uploads a 2048x2048 texture in each
+// compressed format the driver exposes, and in RGBA8 for comparison, and
+// reports upload bandwidth, the size the driver says it keeps, and sampling
+// throughput. The blocks are noise, which every format decodes to something
+// (ASTC may decode some of it as error blocks) at the same cost.
+void BenchmarkCompressedTextures() {
+    struct CompressedFormat {
+        const char* name;
+        GLenum internal_format;
+        int block_size, block_bytes;
+        bool available;
+    };
+    bool have_s3tc = HasGLExtension("GL_EXT_texture_compression_s3tc");
+    bool have_etc2 = HasGLVersion(4, 3) || HasGLExtension("GL_ARB_ES3_compatibility");
+    bool have_astc = HasGLExtension("GL_KHR_texture_compression_astc_ldr");
+    const CompressedFormat formats[] = {
+        { "RGBA8", GL_RGBA8, 1, 4, true },
+        { "DXT1", GL_COMPRESSED_RGB_S3TC_DXT1_EXT, 4, 8, have_s3tc },
+        { "DXT5", GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, 4, 16, have_s3tc },
+        { "ETC2 RGB", GL_COMPRESSED_RGB8_ETC2, 4, 8, have_etc2 },
+        { "ETC2 RGBA", GL_COMPRESSED_RGBA8_ETC2_EAC, 4, 16, have_etc2 },
+        { "ASTC 4x4", GL_COMPRESSED_RGBA_ASTC_4x4_KHR, 4, 16, have_astc },
+        { "ASTC 8x8", GL_COMPRESSED_RGBA_ASTC_8x8_KHR, 8, 16, have_astc },
+    };
+    const int num_formats = sizeof(formats) / sizeof(formats[0]);
+    const int size = 2048;
+    const int layers = 4;
+    const CanvasSize& target_size = canvas_sizes[1];
+
+    if (!HasFramebufferObjects()) {
+        ReportInfo("Benchmark", "Compressed textures: framebuffer objects not available.");
+        return;
+    }
+    GLuint program = CreateProgram(fullscreen_vertex_shader, textured_fragment_shader, NULL);
+    if (program == 0) {
+        ReportInfo("Benchmark", "Compressed textures: shader failed to compile.");
+        return;
+    }
+
+    size_t rgba8_bytes = (size_t)size * size * 4;
+    std::vector<unsigned char> data(rgba8_bytes);
+    unsigned int seed = 12345;
+    for(size_t b = 0; b < data.size(); b++) {
+        seed = seed * 1103515245 + 12345;
+        data[b] = (unsigned char)(seed >> 16);
+    }
+
+    Framebuffer fb;
+    if (!CreateFramebuffer(&fb, target_size.width, target_size.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+        DestroyFramebuffer(&fb);
+        gl.DeleteProgram(program);
+        ReportInfo("Benchmark", "Compressed textures: framebuffer incomplete.");
+        return;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    gl.UseProgram(program);
+    gl.Uniform1i(gl.GetUniformLocation(program, "tex"), 0);
+
+    sprintf(msg_buf, "Compressed textures (%dx%d, sampled at %s):\n", size, size, target_size.name);
+    std::string report = msg_buf;
+    for(int f = 0; f < num_formats; f++) {
+        const CompressedFormat& format = formats[f];
+        if (!format.available) {
+            sprintf(msg_buf, "%s: unsupported\n", format.name);
+            report += msg_buf;
+            continue;
+        }
+        bool compressed = (format.block_size > 1);
+        int blocks = size / format.block_size;
+        size_t bytes = (size_t)blocks * blocks * format.block_bytes;
+
+        GLuint tex;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        while (glGetError() != GL_NO_ERROR)
+            ;
+
+        std::vector<double> samples;
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        glFinish();
+        double bench_start = GetTime();
+        for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+            BeginGPUTimer(&timer);
+            double start = GetTime();
+            if (compressed)
+                gl.CompressedTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, size, size, 0, (GLsizei)bytes, &data[0]);
+            else
+                glTexImage2D(GL_TEXTURE_2D, 0, format.internal_format, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, &data[0]);
+            EndGPUTimer(&timer);
+            glFinish();
+            samples.push_back(GetTime() - start);
+        }
+        std::string upload_times = FormatGPUTimer(&timer);
+        DestroyGPUTimer(&timer);
+        if (glGetError() != GL_NO_ERROR) {
+            sprintf(msg_buf, "%s: upload failed\n", format.name);
+            report += msg_buf;
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glDeleteTextures(1, &tex);
+            continue;
+        }
+
+        // What the driver says it keeps. Emulated formats may report being
+        // uncompressed, though some just echo back the uploaded size.
+        GLint is_compressed = GL_FALSE, stored_bytes = (GLint)bytes;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &is_compressed);
+        if (is_compressed)
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &stored_bytes);
+
+        std::string sample_times;
+        double per_layer = TimeFullscreenLayers(layers, &sample_times);
+
+        TimingStats stats;
+        ComputeTimingStats(samples, &stats);
+        sprintf(msg_buf, "%s: upload %.2f GB/s (%s), %.1f MB", format.name, bytes / stats.median / 1e9,
+            upload_times.c_str(), bytes / 1e6);
+        report += msg_buf;
+        if (compressed && is_compressed) {
+            sprintf(msg_buf, ", stored in %.0f%% less memory than RGBA8", 100.0 * (1.0 - (double)stored_bytes / rgba8_bytes));
+            report += msg_buf;
+        }
+        else if (compressed) {
+            report += ", but stored uncompressed";
+        }
+        sprintf(msg_buf, ", sample %.1f Msamples/s (%s per %d layers)\n",
+            target_size.width * target_size.height / per_layer / 1e6, sample_times.c_str(), layers);
+        report += msg_buf;
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDeleteTextures(1, &tex);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    gl.UseProgram(0);
+    DestroyFramebuffer(&fb);
+    gl.DeleteProgram(program);
+    ReportInfo("Benchmark", report);
+}
+
+// Lights the canvas from a shadow map with one hardware filtered comparison,
+// or 3x3 of them for softer edges.
+static const char* shadow_single_tap_fragment_shader =
+    "#version 120\n"
+    "uniform sampler2DShadow shadow_map;\n"
+    "varying vec2 uv;\n"
+    "void main() {\n"
+    "    float lit = shadow2D(shadow_map, vec3(uv, 0.5)).r;\n"
+    "    gl_FragColor = vec4(vec3(lit), 1.0);\n"
+    "}\n";
+
+static const char* shadow_pcf_fragment_shader =
+    "#version 120\n"
+    "uniform sampler2DShadow shadow_map;\n"
+    "uniform vec2 texel;\n"
+    "varying vec2 uv;\n"
+    "void main() {\n"
+    "    float lit = 0.0;\n"
+    "    for (int y = -1; y <= 1; y++)\n"
+    "        for (int x = -1; x <= 1; x++)\n"
+    "            lit += shadow2D(shadow_map, vec3(uv + vec2(x, y) * texel, 0.5)).r;\n"
+    "    gl_FragColor = vec4(vec3(lit / 9.0), 1.0);\n"
+    "}\n";
+
+// Shadow mapping is usually the most expensive pass in 3D content. Renders a
+// bumpy grid of triangles into a 2048x2048 depth texture with color writes
+// off, then lights a 1080p canvas from it with hardware comparison filtering,
+// and reports how long each pass takes.
+void BenchmarkShadowMap() {
+    const int shadow_size = 2048;
+    const int grid = 256;
+    const CanvasSize& size = canvas_sizes[1];
+    const int layers = 4;
+
+    if (!HasFramebufferObjects() || !HasDepthTextures()) {
+        ReportInfo("Benchmark", "Shadow map: depth textures not available.");
+        return;
+    }
+    GLuint depth_program = CreateProgram(fullscreen_vertex_shader, trivial_fragment_shader, NULL);
+    GLuint shade_programs[2];
+    static const char* shade_names[] = { "1 tap", "3x3 PCF" };
+    shade_programs[0] = CreateProgram(fullscreen_vertex_shader, shadow_single_tap_fragment_shader, NULL);
+    shade_programs[1] = CreateProgram(fullscreen_vertex_shader, shadow_pcf_fragment_shader, NULL);
+    if (depth_program == 0 || shade_programs[0] == 0 || shade_programs[1] == 0) {
+        if (depth_program != 0)
+            gl.DeleteProgram(depth_program);
+        for(int p = 0; p < 2; p++) {
+            if (shade_programs[p] != 0)
+                gl.DeleteProgram(shade_programs[p]);
+        }
+        ReportInfo("Benchmark", "Shadow map: shader failed to compile.");
+        return;
+    }
+
+    // A grid over the whole map with depth varying across it, drawn as
+    // separate triangles.
+    std::vector<GLfloat> vertices;
+    for(int y = 0; y < grid; y++) {
+        for(int x = 0; x < grid; x++) {
+            float x0 = -1.f + 2.f * x / grid, x1 = -1.f + 2.f * (x + 1) / grid;
+            float y0 = -1.f + 2.f * y / grid, y1 = -1.f + 2.f * (y + 1) / grid;
+            float z0 = 0.5f * (float)sin(x0 * 7.f) * (float)cos(y0 * 5.f);
+            float z1 = 0.5f * (float)sin(x1 * 7.f) * (float)cos(y1 * 5.f);
+            GLfloat quad[] = {
+                x0, y0, z0, x1, y0, z1, x0, y1, z0,
+                x1, y0, z1, x1, y1, z1, x0, y1, z0,
+            };
+            vertices.insert(vertices.end(), quad, quad + 18);
+        }
+    }
+    const int triangles = grid * grid * 2;
+    GLuint vertex_buffer;
+    gl.GenBuffers(1, &vertex_buffer);
+    gl.BindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    gl.BufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), &vertices[0], GL_STATIC_DRAW);
+    gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+    std::string report = "Shadow map:\n";
+    Framebuffer shadow_fb;
+    const DepthFormat& format = depth_formats[1];
+    if (!CreateDepthFramebuffer(&shadow_fb, shadow_size, shadow_size, format)) {
+        sprintf(msg_buf, "%s depth texture: framebuffer incomplete\n", format.name);
+        report += msg_buf;
+    }
+    else {
+        // Depth pass.
+        gl.UseProgram(depth_program);
+        gl.BindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+        gl.VertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+        gl.EnableVertexAttribArray(0);
+        glEnable(GL_DEPTH_TEST);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+        std::vector<double> samples;
+        GPUTimer timer;
+        InitGPUTimer(&timer);
+        glFinish();
+        double bench_start = GetTime();
+        for(int i = 0; KeepBenchmarking(i, bench_start); i++) {
+            BeginGPUTimer(&timer);
+            double start = GetTime();
+            glClear(GL_DEPTH_BUFFER_BIT);
+            glDrawArrays(GL_TRIANGLES, 0, triangles * 3);
+            EndGPUTimer(&timer);
+            glFinish();
+            samples.push_back(GetTime() - start);
+        }
+        TimingStats stats;
+        ComputeTimingStats(samples, &stats);
+        sprintf(msg_buf, "Depth pass (%dx%d %s, %d triangles): %.2f ms, %.1f Mtriangles/s (%s)\n",
+            shadow_size, shadow_size, format.name, triangles, stats.median * 1000.0,
+            triangles / stats.median / 1e6, FormatGPUTimer(&timer).c_str());
+        report += msg_buf;
+        DestroyGPUTimer(&timer);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDisable(GL_DEPTH_TEST);
+        gl.DisableVertexAttribArray(0);
+        gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // Shading passes, with linear filtering so the hardware blends
+        // neighbouring comparisons where it can.
+        glBindTexture(GL_TEXTURE_2D, shadow_fb.tex);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+        Framebuffer fb;
+        if (CreateFramebuffer(&fb, size.width, size.height, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE)) {
+            glBindTexture(GL_TEXTURE_2D, shadow_fb.tex);
+            for(int p = 0; p < 2; p++) {
+                gl.UseProgram(shade_programs[p]);
+                gl.Uniform1i(gl.GetUniformLocation(shade_programs[p], "shadow_map"), 0);
+                GLint texel_location = gl.GetUniformLocation(shade_programs[p], "texel");
+                GLfloat texel[] = { 1.f / shadow_size, 1.f / shadow_size };
+                if (texel_location >= 0)
+                    gl.Uniform2fv(texel_location, 1, texel);
+                std::string times;
+                double per_layer = TimeFullscreenLayers(layers, &times);
+                sprintf(msg_buf, "Shading at %s, %s: %.2f ms, %.1f Mpixels/s (%s per %d layers)\n", size.name,
+                    shade_names[p], per_layer * 1000.0, size.width * size.height / per_layer / 1e6, times.c_str(), layers);
+                report += msg_buf;
+            }
+            glBindTexture(GL_TEXTURE_2D, 0);
+            gl.UseProgram(0);
+        }
+        else {
+            sprintf(msg_buf, "Shading at %s: framebuffer incomplete\n", size.name);
+            report += msg_buf;
+        }
+        DestroyFramebuffer(&fb);
+    }
+    DestroyFramebuffer(&shadow_fb);
+
+    gl.DeleteBuffers(1, &vertex_buffer);
+    gl.DeleteProgram(depth_program);
+    gl.DeleteProgram(shade_programs[0]);
+    gl.DeleteProgram(shade_programs[1]);
+    ReportInfo("Benchmark", report);
+}